@@ -0,0 +1,53 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef COLOR_WIDGETS_BUILTIN_PALETTE_HPP
+#define COLOR_WIDGETS_BUILTIN_PALETTE_HPP
+
+namespace color_widgets
+{
+
+/**
+ * \brief Color entry of a BuiltinPalette
+ */
+struct BuiltinColor
+{
+  unsigned int rgb; ///< Color as 0xRRGGBB
+  const char* name; ///< UTF-8 name, may be empty
+};
+
+/**
+ * \brief Palette stored in static data
+ *
+ * These are meant to be generated from Gimp palette files at build time
+ * with the color_widgets_embed_palettes() CMake function, they can be added
+ * to a ColorPaletteModel without parsing or copying their colors.
+ */
+struct BuiltinPalette
+{
+  const char* name;           ///< UTF-8 name
+  int columns;                ///< Number of columns, 0 if unspecified
+  const BuiltinColor* colors; ///< Colors, must outlive all palettes using it
+  int count;                  ///< Number of colors
+};
+
+} // namespace color_widgets
+#endif // COLOR_WIDGETS_BUILTIN_PALETTE_HPP
@@ -22,6 +22,7 @@
 #ifndef COLOR_WIDGETS_COLOR_2D_SLIDER_HPP
 #define COLOR_WIDGETS_COLOR_2D_SLIDER_HPP
 
+#include "color_f.hpp"
 #include "colorwidgets_global.hpp"
 
 #include <QWidget>
@@ -49,22 +50,62 @@ class QCP_EXPORT Color2DSlider final : public QWidget
    * \brief Which color component is used on the y axis
    */
   Q_PROPERTY(Component componentY READ componentY WRITE setComponentY NOTIFY componentYChanged)
+  /**
+   * \brief Color model the components belong to
+   */
+  Q_PROPERTY(Model model READ model WRITE setModel NOTIFY modelChanged)
+  /**
+   * \brief Whether OkLab colors outside the RGB gamut are marked with stripes
+   */
+  Q_PROPERTY(
+      bool gamutOverlay READ gamutOverlay WRITE setGamutOverlay NOTIFY gamutOverlayChanged)
 
 public:
+  /**
+   * \brief Component of the color model shown on an axis
+   */
   enum Component
   {
-    Hue,
-    Saturation,
-    Value
+    Hue,              ///< Hue, OKLab a for OkLab
+    Saturation,       ///< Saturation, chroma for Lch, OKLab b for OkLab
+    Value,            ///< Value, lightness for Hsl and OkLab, luma for Lch
+    LabA = Hue,       ///< OKLab a, from -0.4 to 0.4
+    LabB = Saturation ///< OKLab b, from -0.4 to 0.4
   };
   Q_ENUMS(Component)
 
+  /**
+   * \brief Color model used to map the axes to colors
+   */
+  enum Model
+  {
+    Hsv,  ///< Hue, Saturation, Value
+    Hsl,  ///< Hue, Saturation, Lightness
+    Lch,  ///< Hue, Chroma, Y'601 luma
+    /**
+     * OKLab a, b and lightness
+     *
+     * Colors outside the RGB gamut have their chroma reduced, keeping
+     * lightness and hue.
+     */
+    OkLab
+  };
+  Q_ENUMS(Model)
+
   explicit Color2DSlider(QWidget* parent = nullptr);
   ~Color2DSlider() override;
 
   /// Get current color
   QColor color() const;
 
+  /// Get current color, along with its HSV components
+  ColorF colorF() const;
+
+  /**
+   * \brief Set current color from its HSV components
+   */
+  void setColorF(const ColorF& c);
+
   QSize sizeHint() const Q_DECL_OVERRIDE;
 
   /// Get current hue in the range [0-1]
@@ -78,6 +119,8 @@ public:
 
   Component componentX() const;
   Component componentY() const;
+  Model model() const;
+  bool gamutOverlay() const;
 
 public Q_SLOTS:
 
@@ -101,6 +144,11 @@ public Q_SLOTS:
 
   void setComponentX(Component componentX);
   void setComponentY(Component componentY);
+  /**
+   * \brief Changes the color model, keeping the current color
+   */
+  void setModel(Model model);
+  void setGamutOverlay(bool gamutOverlay);
 
 Q_SIGNALS:
   /**
@@ -115,6 +163,8 @@ Q_SIGNALS:
 
   void componentXChanged(Component componentX);
   void componentYChanged(Component componentY);
+  void modelChanged(Model model);
+  void gamutOverlayChanged(bool gamutOverlay);
 
 protected:
   void paintEvent(QPaintEvent* event) Q_DECL_OVERRIDE;
@@ -23,6 +23,7 @@
 #define COLOR_DIALOG_HPP
 
 #include "color_preview.hpp"
+#include "color_state.hpp"
 #include "color_wheel.hpp"
 #include "colorwidgets_global.hpp"
 
@@ -53,6 +54,13 @@ public:
    */
   QColor color() const;
 
+  /**
+   * \brief Color shared by the dialog widgets
+   *
+   * Other widgets can be bound to it to follow the dialog color.
+   */
+  ColorState* colorState() const;
+
   /**
    * Set the display mode for the color preview
    */
@@ -116,10 +124,6 @@ public:
   void alphaEnabledChanged(bool alphaEnabled) W_SIGNAL(alphaEnabledChanged, alphaEnabled)
 
 private Q_SLOTS:
-  /// Update all the Ui elements to match the selected color
-  void update_widgets();
-  W_SLOT(update_widgets)
-
   /// Update from HSV sliders
   void set_hsv();
   W_SLOT(set_hsv)
@@ -128,6 +132,14 @@ private Q_SLOTS:
   void set_rgb();
   W_SLOT(set_rgb)
 
+  /// Update from the alpha slider
+  void set_alpha();
+  W_SLOT(set_alpha)
+
+  /// Update from the wheel
+  void set_wheel();
+  W_SLOT(set_wheel)
+
   void on_edit_hex_colorChanged(const QColor& color);
   W_SLOT(on_edit_hex_colorChanged)
 
@@ -140,6 +152,9 @@ private Q_SLOTS:
 private:
   void setColorInternal(const QColor& color);
 
+  /// Update the Ui elements showing the changed components
+  void update_widgets(ColorState::Components changes);
+
 protected:
   void dragEnterEvent(QDragEnterEvent* event) override;
   void dropEvent(QDropEvent* event) override;
@@ -0,0 +1,86 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef COLOR_WIDGETS_COLOR_DISTANCE_HPP
+#define COLOR_WIDGETS_COLOR_DISTANCE_HPP
+
+#include "color_palette.hpp"
+
+namespace color_widgets
+{
+
+/**
+ * \brief Computes color differences with a selectable metric
+ *
+ * Alpha is always ignored. Batch functions convert the colors once and work
+ * on packed component arrays, all-pairs matrices are split across threads.
+ */
+class QCP_EXPORT ColorDistance
+{
+public:
+  enum Metric
+  {
+    Rgb,       ///< Euclidean distance on 8 bit sRGB components, in [0, 441]
+    OkLab,     ///< Euclidean distance in OKLab, about 0.02 is noticeable
+    Cie76,     ///< Euclidean distance in CIE L*a*b*, about 2.3 is noticeable
+    Ciede2000, ///< CIEDE2000 color difference, about 1 is noticeable
+  };
+
+  explicit ColorDistance(Metric metric = OkLab);
+  ColorDistance(const ColorDistance& other);
+  ColorDistance& operator=(const ColorDistance& other);
+  ~ColorDistance();
+
+  Metric metric() const;
+  void setMetric(Metric metric);
+
+  /**
+   * \brief Maximum number of threads, 0 (the default) uses all the cores
+   */
+  int threadCount() const;
+  void setThreadCount(int threads);
+
+  float distance(QRgb a, QRgb b) const;
+  float distance(const QColor& a, const QColor& b) const;
+
+  /**
+   * \brief Distances from \p color to each of \p colors
+   */
+  QVector<float> distances(QRgb color, const QVector<QRgb>& colors) const;
+  QVector<float> distances(const QColor& color, const ColorPalette& palette) const;
+
+  /**
+   * \brief Distances between all the pairs of \p colors
+   * \returns Symmetric matrix of colors.size() rows, row by row, or an
+   *          empty vector if it doesn't fit in a QVector (more than about
+   *          23000 colors)
+   */
+  QVector<float> matrix(const QVector<QRgb>& colors) const;
+  QVector<float> matrix(const ColorPalette& palette) const;
+
+private:
+  class Private;
+  Private* p;
+};
+
+} // namespace color_widgets
+
+#endif // COLOR_WIDGETS_COLOR_DISTANCE_HPP
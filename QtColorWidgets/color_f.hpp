@@ -0,0 +1,130 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef COLOR_WIDGETS_COLOR_F_HPP
+#define COLOR_WIDGETS_COLOR_F_HPP
+
+#include <QColor>
+
+namespace color_widgets
+{
+
+/**
+ * \brief Plain float RGBA color with its HSV components
+ *
+ * Unlike QColor it has no color spec: RGB and HSV are both computed when it's
+ * created, so reading either of them doesn't convert anything. Grays keep the
+ * hue they have been created with.
+ */
+struct ColorF
+{
+  float r, g, b, a; ///< RGBA components in [0-1]
+  float h, s, v;    ///< HSV components in [0-1]
+
+  /**
+   * \param gray_hue Hue used if the color is a gray
+   */
+  static constexpr ColorF fromRgbF(float r, float g, float b, float a = 1, float gray_hue = 0)
+  {
+    float max = r > g ? (r > b ? r : b) : (g > b ? g : b);
+    float min = r < g ? (r < b ? r : b) : (g < b ? g : b);
+    float chroma = max - min;
+
+    float hue = gray_hue;
+    if (chroma > 0)
+    {
+      if (max == r)
+        hue = (g - b) / chroma;
+      else if (max == g)
+        hue = (b - r) / chroma + 2;
+      else
+        hue = (r - g) / chroma + 4;
+      hue /= 6;
+      if (hue < 0)
+        hue += 1;
+    }
+
+    return {r, g, b, a, hue, max > 0 ? chroma / max : 0, max};
+  }
+
+  static constexpr ColorF fromHsvF(float h, float s, float v, float a = 1)
+  {
+    float chroma = v * s;
+    float h6 = (h >= 1 ? 0 : h) * 6;
+    int sector = int(h6);
+    float x = sector % 2 ? chroma * (sector + 1 - h6) : chroma * (h6 - sector);
+    float m = v - chroma;
+
+    float r = 0, g = 0, b = 0;
+    switch (sector)
+    {
+      case 0:
+        r = chroma, g = x;
+        break;
+      case 1:
+        r = x, g = chroma;
+        break;
+      case 2:
+        g = chroma, b = x;
+        break;
+      case 3:
+        g = x, b = chroma;
+        break;
+      case 4:
+        r = x, b = chroma;
+        break;
+      default:
+        r = chroma, b = x;
+        break;
+    }
+
+    return {r + m, g + m, b + m, a, h, s, v};
+  }
+
+  /**
+   * \brief Converts a QColor, reading the HSV components directly from HSV colors
+   */
+  static ColorF fromColor(const QColor& color)
+  {
+    if (color.spec() == QColor::Hsv)
+    {
+      return fromHsvF(
+          qMax<float>(0, color.hsvHueF()),
+          color.hsvSaturationF(),
+          color.valueF(),
+          color.alphaF());
+    }
+
+    QColor rgb = color.toRgb();
+    return fromRgbF(rgb.redF(), rgb.greenF(), rgb.blueF(), rgb.alphaF());
+  }
+
+  QColor toColor() const { return QColor::fromRgbF(r, g, b, a); }
+
+  QRgb rgba() const
+  {
+    return qRgba(
+        int(r * 255 + 0.5f), int(g * 255 + 0.5f), int(b * 255 + 0.5f), int(a * 255 + 0.5f));
+  }
+};
+
+} // namespace color_widgets
+#endif // COLOR_WIDGETS_COLOR_F_HPP
@@ -22,6 +22,7 @@
 #ifndef COLOR_WIDGETS_COLOR_LINE_EDIT_HPP
 #define COLOR_WIDGETS_COLOR_LINE_EDIT_HPP
 
+#include "color_palette_model.hpp"
 #include "colorwidgets_global.hpp"
 
 #include <QColor>
@@ -44,6 +45,9 @@ namespace color_widgets
  * Additional string formats supported when showAlpha is true:
  *  * Long hex strings  #ff0000ff
  *  * Function like     rgba(255,0,0,255)
+ *
+ * When completeNames is true, typing shows a list of matching color names,
+ * taken from the SVG color names and the color names in paletteModel.
  */
 class QCP_EXPORT ColorLineEdit final : public QLineEdit
 {
@@ -56,6 +60,8 @@ public:
   QColor color() const;
   bool showAlpha() const;
   bool previewColor() const;
+  bool completeNames() const;
+  ColorPaletteModel* paletteModel() const;
 
   void setColor(const QColor& color);
   W_SLOT(setColor)
@@ -63,6 +69,10 @@ public:
   W_SLOT(setShowAlpha)
   void setPreviewColor(bool previewColor);
   W_SLOT(setPreviewColor)
+  void setCompleteNames(bool completeNames);
+  W_SLOT(setCompleteNames)
+  void setPaletteModel(ColorPaletteModel* paletteModel);
+  W_SLOT(setPaletteModel)
 
   /**
    * \brief Emitted when the color is changed by any means
@@ -79,6 +89,7 @@ public:
 
   void showAlphaChanged(bool showAlpha) W_SIGNAL(showAlphaChanged, showAlpha)
   void previewColorChanged(bool previewColor) W_SIGNAL(previewColorChanged, previewColor)
+  void completeNamesChanged(bool completeNames) W_SIGNAL(completeNamesChanged, completeNames)
 
   W_PROPERTY(QColor, color READ color WRITE setColor NOTIFY colorChanged)
   /**
@@ -90,6 +101,12 @@ public:
    * color
    */
   W_PROPERTY(bool, previewColor READ previewColor WRITE setPreviewColor NOTIFY previewColorChanged)
+  /**
+   * \brief Whether to show a completion popup with color names while typing
+   */
+  W_PROPERTY(
+      bool,
+      completeNames READ completeNames WRITE setCompleteNames NOTIFY completeNamesChanged)
 
 protected:
   void dragEnterEvent(QDragEnterEvent* event) Q_DECL_OVERRIDE;
@@ -49,8 +49,24 @@ QColor colorFromString(const QString& string, bool alpha = true);
  * Format:
  *  * If the color has full alpha: #ff0000
  *  * If alpha is true and the color has non-full alpha: #ff000088
+ *  * If names is true and the color has full alpha and matches a SVG color
+ *    name exactly: red
  */
-QString stringFromColor(const QColor& color, bool alpha = true);
+QString stringFromColor(const QColor& color, bool alpha = true, bool names = false);
+
+/**
+ * \brief SVG name of the given color
+ * \returns An empty string if the color isn't fully opaque or doesn't match
+ *          any name exactly
+ */
+QString colorName(const QColor& color);
+
+/**
+ * \brief SVG name of the color closest to the given one (alpha is ignored)
+ * \param distance If not null, receives the euclidean RGB distance between
+ *                 \p color and the named color
+ */
+QString nearestColorName(const QColor& color, int* distance = nullptr);
 
 } // namespace color_widgets
 #endif // COLOR_WIDGETS_COLOR_NAMES_HPP
@@ -22,6 +22,7 @@
 #ifndef COLOR_WIDGETS_COLOR_PALETTE_HPP
 #define COLOR_WIDGETS_COLOR_PALETTE_HPP
 
+#include "builtin_palette.hpp"
 #include "colorwidgets_global.hpp"
 
 #include <QColor>
@@ -31,10 +32,14 @@
 #include <QString>
 #include <QVector>
 
+#include <functional>
+
 #include <verdigris>
 namespace color_widgets
 {
 
+class PaletteSource;
+
 class QCP_EXPORT ColorPalette final : public QObject
 {
   W_OBJECT(ColorPalette)
@@ -42,11 +47,41 @@ class QCP_EXPORT ColorPalette final : public QObject
 public:
   typedef QPair<QColor, QString> value_type;
 
+  /**
+   * \brief Criteria used by sortBy()
+   */
+  enum SortKey
+  {
+    SortHue,        ///< HSV hue, grays first, ties broken by value
+    SortSaturation, ///< HSV saturation, ties broken by value
+    SortValue,      ///< HSV value, ties broken by saturation
+    SortLuma,       ///< Luma (Y'601)
+    SortLightness,  ///< Perceptual lightness (OKLab L)
+    SortSmooth      ///< Nearest neighbour chain starting from the darkest color
+  };
+  W_ENUM(SortKey, SortHue, SortSaturation, SortValue, SortLuma, SortLightness, SortSmooth)
+
   ColorPalette(
       const QVector<QPair<QColor, QString>>& colors,
       const QString& name = QString(),
       int columns = 0);
   explicit ColorPalette(const QString& name = QString());
+  /**
+   * \brief Palette reading its colors from static data
+   *
+   * The colors are not copied until the palette is modified, \p palette must
+   * outlive this object and its copies.
+   */
+  explicit ColorPalette(const BuiltinPalette& palette);
+  /**
+   * \brief Palette reading its colors from a generator
+   *
+   * Colors are computed when they're read and they aren't stored until the
+   * palette is modified. \p source is copied, copies of the palette share
+   * that copy.
+   */
+  explicit ColorPalette(
+      const PaletteSource& source, const QString& name = QString(), int columns = 0);
   ColorPalette(const ColorPalette& other);
   ColorPalette& operator=(const ColorPalette& other);
   ~ColorPalette();
@@ -96,6 +131,31 @@ public:
    */
   static ColorPalette fromImage(const QImage& image);
 
+  /**
+   * \brief Called with the number of processed and total pixels, returning
+   * \b false cancels the operation
+   */
+  using Progress = std::function<bool(qint64 done, qint64 total)>;
+
+  /**
+   * \brief Set the palette to the dominant colors of an image file
+   * \param file_name  Image file name
+   * \param max_colors Maximum number of colors
+   * \param progress   Optional progress callback
+   *
+   * Unlike loadImage(), which uses every pixel as a color, this reduces the
+   * image to at most \p max_colors colors sorted by frequency.
+   * Images up to about 16M pixels are read whole. Larger images are read in
+   * tiles of that size if their format can decode a part of the image (eg:
+   * JPEG), with \p progress called after each tile. Otherwise they are
+   * decoded at a reduced size, which depending on the format may still need
+   * the whole image in memory while decoding.
+   * \returns \b false if the image can't be read or the operation has been
+   *          cancelled, the palette is left unchanged in that case
+   */
+  bool loadImageColors(
+      const QString& file_name, int max_colors = 256, const Progress& progress = Progress());
+
   /**
    * \brief Load contents from a Gimp palette (gpl) file
    * \returns \b true On Success
@@ -154,6 +214,37 @@ public:
   void eraseColor(int index);
   W_SLOT(eraseColor)
 
+  /**
+   * \brief Sort the colors, keeping each name with its color
+   *
+   * Sort keys are computed once per color and the sort is stable,
+   * colorsChanged() is emitted once at the end.
+   */
+  void sortBy(SortKey key);
+  W_SLOT(sortBy)
+
+  /**
+   * \brief Remove colors with the same RGBA value as an earlier one
+   *
+   * The first occurrence is kept, if it has no name it takes the first
+   * non-empty name among its duplicates.
+   * \returns The number of removed colors
+   */
+  int removeDuplicates();
+  W_SLOT(removeDuplicates)
+
+  /**
+   * \brief Merge colors closer than \p tolerance into a single entry
+   * \param tolerance Maximum euclidean distance in RGBA (0-255 per channel)
+   *
+   * Colors are visited in order, each one is merged into the closest earlier
+   * kept color within \p tolerance (if any). Names are kept as in
+   * removeDuplicates().
+   * \returns The number of removed colors
+   */
+  int mergeSimilar(int tolerance);
+  W_SLOT(mergeSimilar)
+
   /**
    * \brief Change file name and save
    * \returns \b true on success
@@ -26,6 +26,8 @@
 
 #include <QAbstractListModel>
 
+#include <cstddef>
+
 namespace color_widgets
 {
 
@@ -34,6 +36,35 @@ class Q_DECL_EXPORT ColorPaletteModel final : public QAbstractListModel
   W_OBJECT(ColorPaletteModel)
 
 public:
+  /**
+   * \brief Color entry found by findColor()
+   */
+  struct ColorMatch
+  {
+    int palette;  ///< Index of the palette in the model
+    int index;    ///< Index of the color in the palette
+    int distance; ///< Euclidean RGB distance from the searched color
+  };
+
+  /**
+   * \brief Palette found by similarPalettes()
+   */
+  struct PaletteMatch
+  {
+    int palette;    ///< Index of the palette in the model
+    float distance; ///< Signature distance, from 0 (same) to 2 (disjoint)
+  };
+
+  /**
+   * \brief Palette or color name found by findNames()
+   */
+  struct NameMatch
+  {
+    int palette; ///< Index of the palette in the model
+    int index;   ///< Index of the color in the palette, -1 for the palette name
+    float score; ///< 1 for names containing the searched text, less for similar names
+  };
+
   ColorPaletteModel();
   ~ColorPaletteModel() override;
   int rowCount(const QModelIndex& parent = QModelIndex()) const Q_DECL_OVERRIDE;
@@ -79,6 +110,8 @@ public:
    * If all of the above fail, the palette will be replaced interally
    * but not on the filesystem
    *
+   * Emits dataChanged() for the palette's row.
+   *
    * \returns \b true if the palette has been successfully updated (and saved)
    */
   bool updatePalette(int index, const ColorPalette& palette, bool save = true);
@@ -95,12 +128,76 @@ public:
    */
   bool addPalette(const ColorPalette& palette, bool save = true);
 
+  /**
+   * \brief Add palettes stored in static data
+   * \param palettes Array of \p count palettes, it must outlive the model
+   *
+   * The palettes are appended to the model and their colors are read in
+   * place until they are modified. load() lists them before the palettes
+   * found in the search paths, even if they have been removed.
+   */
+  void addBuiltinPalettes(const BuiltinPalette* palettes, int count);
+
+  /**
+   * \brief Add an array of palettes generated by color_widgets_embed_palettes()
+   */
+  template<std::size_t Count>
+  void addBuiltinPalettes(const BuiltinPalette (&palettes)[Count])
+  {
+    addBuiltinPalettes(palettes, int(Count));
+  }
+
   /**
    * \brief The index of the palette with the given file name
    * \returns -1 if none is found
    */
   int indexFromFile(const QString& filename) const;
 
+  /**
+   * \brief Find palette colors close to \p color
+   * \param color        Color to search
+   * \param max_distance Maximum euclidean RGB distance (0-255 per channel)
+   * \param max_results  Maximum number of results, -1 for no limit
+   * \returns Matches sorted by distance, then palette and color index
+   *
+   * This uses an index kept up to date by load(), addPalette(),
+   * updatePalette() and removePalette() so it doesn't need to scan all the
+   * palettes.
+   */
+  QVector<ColorMatch> findColor(const QColor& color, int max_distance = 0, int max_results = -1)
+      const;
+
+  /**
+   * \brief Palettes with a color distribution similar to \p palette
+   * \param max_results Maximum number of results, -1 for no limit
+   * \returns Matches sorted by distance
+   *
+   * Each palette is summarized by a small perceptual color histogram,
+   * computed when it's added to the model, so the search doesn't need to go
+   * through the colors of every palette.
+   */
+  QVector<PaletteMatch> similarPalettes(const ColorPalette& palette, int max_results = -1) const;
+
+  /**
+   * \brief Palettes similar to the one at \p index, excluding itself
+   * \pre 0 <= index < count()
+   */
+  QVector<PaletteMatch> similarPalettes(int index, int max_results = -1) const;
+
+  /**
+   * \brief Search palette and color names
+   * \param text        Text to search, case insensitive
+   * \param max_results Maximum number of results, -1 for no limit
+   * \param fuzzy       Whether to include names sharing most of their
+   *                    trigrams with \p text but not containing it
+   * \returns Matches sorted by score, then by shorter name
+   *
+   * Names are looked up in a trigram index. When \p text extends the text of
+   * the previous search (as it happens while the user types) only the
+   * previous results are filtered.
+   */
+  QVector<NameMatch> findNames(const QString& text, int max_results = -1, bool fuzzy = true) const;
+
   void setSavePath(const QString& savePath);
   W_SLOT(setSavePath)
   void setSearchPaths(const QStringList& searchPaths);
@@ -0,0 +1,126 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef COLOR_WIDGETS_COLOR_STATE_HPP
+#define COLOR_WIDGETS_COLOR_STATE_HPP
+
+#include "color_f.hpp"
+#include "colorwidgets_global.hpp"
+
+#include <QObject>
+
+#include <verdigris>
+namespace color_widgets
+{
+
+/**
+ * \brief Current color shared by a group of widgets
+ *
+ * Widgets write to it with the setters and update from changed(), instead of
+ * being connected to each other. Each modification results in a single
+ * changed() listing the components that differ, setters called between
+ * beginUpdate() and endUpdate() or from a changed() handler are merged in
+ * the following notification rather than emitting recursively.
+ */
+class QCP_EXPORT ColorState final : public QObject
+{
+  W_OBJECT(ColorState)
+
+public:
+  enum Component
+  {
+    Red = 0x01,
+    Green = 0x02,
+    Blue = 0x04,
+    Hue = 0x08,
+    Saturation = 0x10,
+    Value = 0x20,
+    Alpha = 0x40,
+
+    Rgb = Red | Green | Blue,
+    Hsv = Hue | Saturation | Value,
+    AllComponents = Rgb | Hsv | Alpha
+  };
+  Q_DECLARE_FLAGS(Components, Component)
+  W_FLAG(
+      Components, Red, Green, Blue, Hue, Saturation, Value, Alpha, Rgb, Hsv, AllComponents)
+
+  explicit ColorState(QObject* parent = nullptr);
+  ~ColorState() override;
+
+  ColorF colorF() const;
+  QColor color() const;
+
+  /**
+   * \brief Incremented for every changed() notification
+   */
+  quint64 version() const;
+
+  /**
+   * \brief Object passed to the setters for the changes being notified
+   *
+   * Null if the setters had no source or different ones. Bound widgets can
+   * use this to skip updating from their own changes.
+   */
+  QObject* source() const;
+
+  /**
+   * \brief Delay notifications until the matching endUpdate()
+   *
+   * Calls can be nested.
+   */
+  void beginUpdate();
+  void endUpdate();
+
+  /**
+   * \brief Sets all the components
+   * \param source Object making the change, see source()
+   */
+  void setColorF(const ColorF& color, QObject* source = nullptr);
+  void setColor(const QColor& color, QObject* source = nullptr);
+
+  /**
+   * \brief Sets the RGB components, keeping alpha and the hue of grays
+   */
+  void setRgbF(float red, float green, float blue, QObject* source = nullptr);
+
+  /**
+   * \brief Sets the HSV components, keeping alpha
+   */
+  void setHsvF(float hue, float saturation, float value, QObject* source = nullptr);
+
+  void setAlphaF(float alpha, QObject* source = nullptr);
+
+  /**
+   * \brief Emitted once per modification, with the components that have changed
+   */
+  void changed(ColorState::Components changes) W_SIGNAL(changed, changes)
+
+private:
+  class Private;
+  Private* p;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(ColorState::Components)
+} // namespace color_widgets
+
+W_REGISTER_ARGTYPE(color_widgets::ColorState::Components)
+#endif // COLOR_WIDGETS_COLOR_STATE_HPP
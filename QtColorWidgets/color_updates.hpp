@@ -0,0 +1,57 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef COLOR_WIDGETS_COLOR_UPDATES_HPP
+#define COLOR_WIDGETS_COLOR_UPDATES_HPP
+
+#include "colorwidgets_global.hpp"
+
+namespace color_widgets
+{
+
+/**
+ * \brief Largest difference between color components (in [0-1]) that color
+ * setters treat as no change
+ *
+ * Defaults to half a step of an 8 bit channel, so colors that went through
+ * 8 bit values don't update widgets again.
+ */
+QCP_EXPORT qreal colorTolerance();
+QCP_EXPORT void setColorTolerance(qreal tolerance);
+
+/**
+ * \brief What color setters did with the calls they received
+ */
+struct ColorUpdateStats
+{
+  quint64 executed = 0;   ///< Calls that changed the widget
+  quint64 suppressed = 0; ///< Calls with a value equal to the current one
+  quint64 reentrant = 0;  ///< Calls made while the same widget was still updating
+};
+
+/**
+ * \brief Counts of the setter calls for all the widgets, for debugging bindings
+ */
+QCP_EXPORT ColorUpdateStats colorUpdateStats();
+QCP_EXPORT void resetColorUpdateStats();
+
+} // namespace color_widgets
+#endif // COLOR_WIDGETS_COLOR_UPDATES_HPP
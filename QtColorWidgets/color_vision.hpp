@@ -0,0 +1,72 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef COLOR_WIDGETS_COLOR_VISION_HPP
+#define COLOR_WIDGETS_COLOR_VISION_HPP
+
+#include "colorwidgets_global.hpp"
+
+#include <QColor>
+#include <QImage>
+
+namespace color_widgets
+{
+
+/**
+ * \brief Color vision deficiencies that can be simulated
+ */
+enum ColorVisionDeficiency
+{
+  NormalVision, ///< No simulation
+  Protanopia,   ///< Missing L (red) cones
+  Deuteranopia, ///< Missing M (green) cones
+  Tritanopia,   ///< Missing S (blue) cones
+};
+
+/**
+ * \brief Deficiency simulated by all the color widgets
+ */
+QCP_EXPORT ColorVisionDeficiency colorVisionSimulation();
+
+/**
+ * \brief Render ColorWheel, Color2DSlider, GradientSlider (and HueSlider)
+ * and Swatch as seen with \p deficiency
+ *
+ * The simulation is applied to the rendered images, so the selected colors
+ * are not affected. Existing widgets are repainted.
+ */
+QCP_EXPORT void setColorVisionSimulation(ColorVisionDeficiency deficiency);
+
+/**
+ * \brief Transforms \p image in place as seen with \p deficiency
+ *
+ * Uses the full severity matrices by Machado et al. (2009) in linear RGB.
+ * Images not in a 32 bit RGB format are converted to QImage::Format_ARGB32.
+ */
+QCP_EXPORT void simulateColorVision(QImage& image, ColorVisionDeficiency deficiency);
+
+/**
+ * \brief \p color as seen with \p deficiency
+ */
+QCP_EXPORT QColor simulateColorVision(const QColor& color, ColorVisionDeficiency deficiency);
+
+} // namespace color_widgets
+#endif // COLOR_WIDGETS_COLOR_VISION_HPP
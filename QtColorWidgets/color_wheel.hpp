@@ -22,6 +22,7 @@
 #ifndef COLOR_WHEEL_HPP
 #define COLOR_WHEEL_HPP
 
+#include "color_f.hpp"
 #include "colorwidgets_global.hpp"
 
 #include <QWidget>
@@ -30,6 +31,8 @@
 namespace color_widgets
 {
 
+class ColorPalette;
+
 /**
  * \brief Display an analog widget that allows the selection of a HSV color
  *
@@ -46,6 +49,7 @@ public:
     SHAPE_DEFAULT = 0x000,  ///< Use the default shape
     SHAPE_TRIANGLE = 0x001, ///< A triangle
     SHAPE_SQUARE = 0x002,   ///< A square
+    SHAPE_DISK = 0x004,     ///< A hue/saturation disk, value is set externally
     SHAPE_FLAGS = 0x00f,    ///< Mask for the shape flags
 
     ANGLE_DEFAULT = 0x000,  ///< Use the default rotation style
@@ -68,6 +72,7 @@ public:
       SHAPE_DEFAULT,
       SHAPE_TRIANGLE,
       SHAPE_SQUARE,
+      SHAPE_DISK,
       SHAPE_FLAGS,
       ANGLE_DEFAULT,
       ANGLE_FIXED,
@@ -87,6 +92,9 @@ public:
   /// Get current color
   QColor color() const;
 
+  /// Get current color, along with its HSV components
+  ColorF colorF() const;
+
   QSize sizeHint() const override;
 
   /// Get current hue in the range [0-1]
@@ -107,6 +115,27 @@ public:
   /// Get display flags
   DisplayFlags displayFlags(DisplayFlags mask = FLAGS_ALL) const;
 
+  /**
+   * \brief Whether LCH colors outside the RGB gamut have their chroma reduced
+   *
+   * Otherwise their RGB components are clipped, which alters hue and luma.
+   * HSV and HSL colors are always in gamut.
+   */
+  bool gamutMapping() const;
+
+  /// Whether LCH colors outside the RGB gamut are marked with stripes in the selector
+  bool gamutOverlay() const;
+
+  /**
+   * \brief Palette edited with markers on the wheel, null if none
+   *
+   * Each color is shown as a marker placed by hue (angle) and saturation
+   * (distance from the center), they can be dragged one at a time or, holding
+   * Shift, all rotated together. Changes are written back to the palette at
+   * most once per frame while dragging.
+   */
+  ColorPalette* markerPalette() const;
+
   /// Set the default display flags
   static void setDefaultDisplayFlags(DisplayFlags flags);
 
@@ -124,6 +153,11 @@ public:
   void setColor(QColor c);
   W_SLOT(setColor)
 
+  /**
+   * \brief Set current color, unlike setColor() grays keep the hue of \p c
+   */
+  void setColorF(const ColorF& c);
+
   /**
    * @param h Hue [0-1]
    */
@@ -149,6 +183,25 @@ public:
   void setDisplayFlags(ColorWheel::DisplayFlags flags);
   W_SLOT(setDisplayFlags)
 
+  void setGamutMapping(bool gamutMapping);
+  W_SLOT(setGamutMapping)
+
+  void setGamutOverlay(bool gamutOverlay);
+  W_SLOT(setGamutOverlay)
+
+  /**
+   * \brief Set the palette edited with markers, it isn't owned by the wheel
+   */
+  void setMarkerPalette(ColorPalette* palette);
+  W_SLOT(setMarkerPalette)
+
+  /**
+   * \brief Rotate the hues of all the markers
+   * \param delta Hue offset, in turns
+   */
+  void rotateMarkers(qreal delta);
+  W_SLOT(rotateMarkers)
+
   /**
    * Emitted when the user selects a color or setColor is called
    */
@@ -162,11 +215,23 @@ public:
   void displayFlagsChanged(ColorWheel::DisplayFlags flags)
       E_SIGNAL(QCP_EXPORT, displayFlagsChanged, flags);
 
+  void gamutMappingChanged(bool gamutMapping)
+      E_SIGNAL(QCP_EXPORT, gamutMappingChanged, gamutMapping);
+  void gamutOverlayChanged(bool gamutOverlay)
+      E_SIGNAL(QCP_EXPORT, gamutOverlayChanged, gamutOverlay);
+  void markerPaletteChanged(ColorPalette* palette)
+      E_SIGNAL(QCP_EXPORT, markerPaletteChanged, palette);
+
   W_PROPERTY(QColor, color READ color WRITE setColor NOTIFY colorChanged)
   W_PROPERTY(qreal, hue READ hue WRITE setHue)
   W_PROPERTY(qreal, saturation READ saturation WRITE setSaturation)
   W_PROPERTY(qreal, value READ value WRITE setValue)
   W_PROPERTY(unsigned, wheelWidth READ wheelWidth WRITE setWheelWidth)
+  W_PROPERTY(bool, gamutMapping READ gamutMapping WRITE setGamutMapping NOTIFY gamutMappingChanged)
+  W_PROPERTY(bool, gamutOverlay READ gamutOverlay WRITE setGamutOverlay NOTIFY gamutOverlayChanged)
+  W_PROPERTY(
+      ColorPalette*,
+      markerPalette READ markerPalette WRITE setMarkerPalette NOTIFY markerPaletteChanged)
   // W_PROPERTY(DisplayFlags, displayFlags READ displayFlags WRITE
   // setDisplayFlags NOTIFY displayFlagsChanged  )
 
@@ -188,4 +253,5 @@ Q_DECLARE_OPERATORS_FOR_FLAGS(ColorWheel::DisplayFlags)
 } // namespace color_widgets
 
 W_REGISTER_ARGTYPE(color_widgets::ColorWheel::DisplayFlags)
+W_REGISTER_ARGTYPE(color_widgets::ColorPalette*)
 #endif // COLOR_WHEEL_HPP
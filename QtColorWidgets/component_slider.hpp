@@ -0,0 +1,138 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef COLOR_WIDGETS_COMPONENT_SLIDER_HPP
+#define COLOR_WIDGETS_COMPONENT_SLIDER_HPP
+
+#include "color_f.hpp"
+#include "gradient_slider.hpp"
+
+#include <verdigris>
+namespace color_widgets
+{
+
+/**
+ * \brief A slider for one component of a color, drawn with its exact gradient
+ *
+ * The background shows the colors obtained by changing only the selected
+ * component of color(). It's rendered one pixel at a time into a cached
+ * strip, which is only updated when it's painted after the other components,
+ * the model or the size have changed.
+ *
+ * The gradient inherited from GradientSlider (colors, gradient, firstColor
+ * and lastColor) is ignored when drawing the background. Its setters still
+ * store the values, but they have no visible effect.
+ */
+class QCP_EXPORT ComponentSlider : public GradientSlider
+{
+  W_OBJECT(ComponentSlider)
+
+public:
+  /**
+   * \brief Color model the components belong to
+   */
+  enum Model
+  {
+    Rgb, ///< Red, Green, Blue
+    Hsv, ///< Hue, Saturation, Value
+    Hsl, ///< Hue, Saturation, Value as HSL lightness
+    Lch  ///< Hue, Saturation as chroma, Value as Y'601 luma
+  };
+  W_ENUM(Model, Rgb, Hsv, Hsl, Lch)
+
+  /**
+   * \brief Component shown by the slider
+   *
+   * Hue and Red, Saturation and Green, Value and Blue select the same
+   * channel of the model.
+   */
+  enum Component
+  {
+    Hue,
+    Saturation,
+    Value,
+    Alpha,
+    Red,
+    Green,
+    Blue
+  };
+  W_ENUM(Component, Hue, Saturation, Value, Alpha, Red, Green, Blue)
+
+  explicit ComponentSlider(QWidget* parent = nullptr);
+  explicit ComponentSlider(Qt::Orientation orientation, QWidget* parent = nullptr);
+  ~ComponentSlider() override;
+
+  Model model() const;
+  void setModel(Model model);
+
+  Component component() const;
+  void setComponent(Component component);
+
+  /**
+   * \brief Color with the selected component taken from the slider position
+   */
+  QColor color() const;
+
+  /**
+   * \brief Like color(), along with its HSV components
+   */
+  ColorF colorF() const;
+
+  /**
+   * \brief Sets the other components and moves the slider to the selected one
+   */
+  void setColorF(const ColorF& color);
+
+  /**
+   * \brief Color the other components are taken from
+   */
+  ColorF context() const;
+
+  /**
+   * \brief Sets the other components without moving the slider
+   *
+   * The gradient is rendered again on the next paint event.
+   */
+  void setContext(const ColorF& color);
+
+  /**
+   * \brief Sets the other components and moves the slider to the selected one
+   *
+   * Grays keep the current hue.
+   */
+  void setColor(const QColor& color);
+  W_SLOT(setColor)
+
+  W_PROPERTY(Model, model READ model WRITE setModel)
+  W_PROPERTY(Component, component READ component WRITE setComponent)
+  W_PROPERTY(QColor, color READ color WRITE setColor)
+
+protected:
+  void paintGradient(QPainter& painter, const QRect& rect) override;
+
+private:
+  class Private;
+  Private* const p;
+};
+
+} // namespace color_widgets
+
+#endif // COLOR_WIDGETS_COMPONENT_SLIDER_HPP
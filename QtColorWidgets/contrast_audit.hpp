@@ -0,0 +1,130 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef COLOR_WIDGETS_CONTRAST_AUDIT_HPP
+#define COLOR_WIDGETS_CONTRAST_AUDIT_HPP
+
+#include "color_palette.hpp"
+
+namespace color_widgets
+{
+
+/**
+ * \brief WCAG 2 contrast ratios between the colors of a palette
+ *
+ * The relative luminance of each color is computed once, the contrast matrix
+ * and the summary are computed when the colors are set.
+ */
+class QCP_EXPORT ContrastAudit
+{
+public:
+  /**
+   * \brief Highest WCAG conformance level met by a contrast ratio
+   */
+  enum Level
+  {
+    Fail,    ///< Below 3:1
+    AALarge, ///< At least 3:1, AA for large text and UI components
+    AA,      ///< At least 4.5:1, AA for normal text (AAA for large text)
+    AAA,     ///< At least 7:1, AAA for normal text
+  };
+
+  /**
+   * \brief Number of color pairs meeting each level
+   *
+   * Each unordered pair of distinct entries is counted once, pairs meeting a
+   * level are counted for all the lower ones too.
+   */
+  struct Summary
+  {
+    int pairs = 0;
+    int aa_large = 0;
+    int aa = 0;
+    int aaa = 0;
+  };
+
+  explicit ContrastAudit(const ColorPalette& palette = ColorPalette());
+  ContrastAudit(const ContrastAudit& other);
+  ContrastAudit& operator=(const ContrastAudit& other);
+  ~ContrastAudit();
+
+  /**
+   * \brief Maximum number of threads, 0 (the default) uses all the cores
+   * \note Only affects the following calls to setPalette() and setColorTable()
+   */
+  int threadCount() const;
+  void setThreadCount(int threads);
+
+  void setPalette(const ColorPalette& palette);
+  void setColorTable(const QVector<QRgb>& colors);
+  QVector<QRgb> colorTable() const;
+
+  /**
+   * \brief Contrast ratios between all the colors
+   * \returns Symmetric matrix of colorTable().size() rows, row by row
+   */
+  QVector<float> matrix() const;
+
+  /**
+   * \brief Contrast ratio between the colors at \p a and \p b
+   */
+  float ratio(int a, int b) const;
+
+  Summary summary() const;
+
+  /**
+   * \brief Pairs (with first < second) whose contrast is below \p required
+   */
+  QVector<QPair<int, int>> failingPairs(Level required) const;
+
+  /**
+   * \brief Contrast ratio of each color against \p background
+   */
+  QVector<float> against(const QColor& background) const;
+
+  /**
+   * \brief WCAG relative luminance, alpha is ignored
+   */
+  static float luminance(QRgb color);
+
+  /**
+   * \brief WCAG contrast ratio, from 1 to 21
+   */
+  static float contrastRatio(QRgb a, QRgb b);
+
+  /**
+   * \brief Minimum contrast ratio for \p level
+   */
+  static float threshold(Level level);
+
+  /**
+   * \brief Highest level met by \p ratio
+   */
+  static Level level(float ratio);
+
+private:
+  class Private;
+  Private* p;
+};
+
+} // namespace color_widgets
+
+#endif // COLOR_WIDGETS_CONTRAST_AUDIT_HPP
@@ -0,0 +1,163 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef COLOR_WIDGETS_GRADIENT_EDITOR_HPP
+#define COLOR_WIDGETS_GRADIENT_EDITOR_HPP
+
+#include "colorwidgets_global.hpp"
+
+#include <QGradient>
+#include <QWidget>
+
+#include <verdigris>
+namespace color_widgets
+{
+
+/**
+ * \brief A widget to edit the stops of a gradient
+ *
+ * It looks like a GradientSlider with a handle for each stop.
+ * Stops can be dragged, double clicking inserts a stop, dragging a stop
+ * away from the widget or pressing Delete removes it.
+ *
+ * The gradient is rendered into a cached strip, a change to a stop only
+ * renders again the part between its neighbours.
+ */
+class QCP_EXPORT GradientEditor : public QWidget
+{
+  W_OBJECT(GradientEditor)
+
+public:
+  /**
+   * \brief Color space the colors are interpolated in
+   *
+   * Interpolation uses premultiplied alpha so transparent stops don't tint
+   * their neighbours.
+   */
+  enum Interpolation
+  {
+    Rgb,       ///< sRGB components, as QGradient
+    LinearRgb, ///< Linear light sRGB
+    OkLab      ///< OKLab, perceptually even steps
+  };
+  W_ENUM(Interpolation, Rgb, LinearRgb, OkLab)
+
+  explicit GradientEditor(QWidget* parent = nullptr);
+  explicit GradientEditor(Qt::Orientation orientation, QWidget* parent = nullptr);
+  ~GradientEditor() override;
+
+  QSize sizeHint() const override;
+
+  QGradientStops stops() const;
+  Qt::Orientation orientation() const;
+  Interpolation interpolation() const;
+  int selectedStop() const;
+  /// Get the background, it's visible for transparent gradient stops
+  QBrush background() const;
+  /// Set the background, it's visible for transparent gradient stops
+  void setBackground(const QBrush& bg);
+
+  /**
+   * \brief Color of the gradient at \p position, interpolated as displayed
+   */
+  QColor colorAt(qreal position) const;
+
+  /**
+   * \brief Index of the stop whose handle is at the given position
+   * \param pos Point in local coordinates
+   * \returns -1 if there's no stop at \p pos
+   */
+  int stopAt(const QPoint& pos) const;
+
+  /**
+   * \brief Add a stop, keeping the stops sorted
+   * \returns The index of the new stop
+   */
+  int insertStop(qreal position, const QColor& color);
+  /**
+   * \brief Change the position of a stop, keeping the stops sorted
+   * \returns The new index of the stop
+   */
+  int moveStop(int index, qreal position);
+  void setStopColor(int index, const QColor& color);
+  void removeStop(int index);
+
+  /**
+   * \brief Set all the stops, they are sorted by position
+   */
+  void setStops(const QGradientStops& stops);
+  W_SLOT(setStops)
+  void setOrientation(Qt::Orientation orientation);
+  W_SLOT(setOrientation)
+  void setInterpolation(Interpolation interpolation);
+  W_SLOT(setInterpolation)
+  /**
+   * \brief Select a stop, -1 to clear the selection
+   */
+  void setSelectedStop(int index);
+  W_SLOT(setSelectedStop)
+  /**
+   * \brief Change the color of the selected stop
+   */
+  void setSelectedColor(const QColor& color);
+  W_SLOT(setSelectedColor)
+
+  /**
+   * \brief Emitted when the stops have been modified, including while dragging
+   */
+  void stopsChanged(const QGradientStops& stops) W_SIGNAL(stopsChanged, stops);
+  void selectedStopChanged(int index) W_SIGNAL(selectedStopChanged, index);
+  void interpolationChanged(Interpolation interpolation)
+      W_SIGNAL(interpolationChanged, interpolation);
+  /**
+   * \brief Emitted when a stop is double clicked, eg: to show a color dialog
+   */
+  void stopDoubleClicked(int index) W_SIGNAL(stopDoubleClicked, index);
+
+  W_PROPERTY(QGradientStops, stops READ stops WRITE setStops NOTIFY stopsChanged)
+  W_PROPERTY(Qt::Orientation, orientation READ orientation WRITE setOrientation)
+  W_PROPERTY(
+      Interpolation,
+      interpolation READ interpolation WRITE setInterpolation NOTIFY interpolationChanged)
+  /**
+   * \brief Index of the selected stop, -1 if none is selected
+   */
+  W_PROPERTY(int, selectedStop READ selectedStop WRITE setSelectedStop NOTIFY selectedStopChanged)
+  W_PROPERTY(QBrush, background READ background WRITE setBackground)
+
+protected:
+  void paintEvent(QPaintEvent* event) override;
+  void mousePressEvent(QMouseEvent* event) override;
+  void mouseMoveEvent(QMouseEvent* event) override;
+  void mouseReleaseEvent(QMouseEvent* event) override;
+  void mouseDoubleClickEvent(QMouseEvent* event) override;
+  void keyPressEvent(QKeyEvent* event) override;
+
+private:
+  class Private;
+  Private* const p;
+};
+
+} // namespace color_widgets
+
+W_REGISTER_ARGTYPE(QGradientStops)
+W_REGISTER_ARGTYPE(color_widgets::GradientEditor::Interpolation)
+#endif // COLOR_WIDGETS_GRADIENT_EDITOR_HPP
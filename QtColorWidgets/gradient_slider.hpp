@@ -29,6 +29,8 @@
 #include <QPen>
 #include <QSlider>
 
+class QPainter;
+
 #include <verdigris>
 namespace color_widgets
 {
@@ -110,6 +112,11 @@ public:
 protected:
   void paintEvent(QPaintEvent* ev) override;
 
+  /**
+   * \brief Draws the gradient over the background, inside the border
+   */
+  virtual void paintGradient(QPainter& painter, const QRect& rect);
+
 private:
   class Private;
   Private* const p;
@@ -23,7 +23,7 @@
 #ifndef HUE_SLIDER_HPP
 #define HUE_SLIDER_HPP
 
-#include "gradient_slider.hpp"
+#include "component_slider.hpp"
 
 #include <verdigris>
 
@@ -33,7 +33,7 @@ namespace color_widgets
 /**
  * \brief A slider for selecting a hue value
  */
-class QCP_EXPORT HueSlider : public GradientSlider
+class QCP_EXPORT HueSlider : public ComponentSlider
 {
   W_OBJECT(HueSlider)
 
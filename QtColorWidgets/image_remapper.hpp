@@ -0,0 +1,120 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef COLOR_WIDGETS_IMAGE_REMAPPER_HPP
+#define COLOR_WIDGETS_IMAGE_REMAPPER_HPP
+
+#include "color_palette.hpp"
+
+#include <QImage>
+
+namespace color_widgets
+{
+
+/**
+ * \brief Maps the pixels of an image onto the colors of a palette
+ *
+ * Nearest colors are looked up in a table covering the whole RGB cube at
+ * reduced precision, built when the palette is set. Images are processed on
+ * multiple threads.
+ *
+ * remap() doesn't modify the object so it can be called from multiple
+ * threads at once.
+ */
+class QCP_EXPORT ImageRemapper
+{
+public:
+  enum Dithering
+  {
+    NoDithering,      ///< Each pixel takes the nearest palette color
+    OrderedDithering, ///< 8x8 Bayer matrix
+    ErrorDiffusion,   ///< Floyd-Steinberg error diffusion
+  };
+
+  enum OutputFormat
+  {
+    IndexedOutput, ///< QImage::Format_Indexed8 with the palette as color table
+    RgbOutput,     ///< QImage::Format_RGB32
+  };
+
+  explicit ImageRemapper(const ColorPalette& palette = ColorPalette());
+  ImageRemapper(const ImageRemapper& other);
+  ImageRemapper& operator=(const ImageRemapper& other);
+  ~ImageRemapper();
+
+  /**
+   * \brief Set the target palette and rebuild the lookup table
+   */
+  void setPalette(const ColorPalette& palette);
+
+  /**
+   * \brief Set the target colors and rebuild the lookup table
+   * \note Alpha is ignored
+   */
+  void setColorTable(const QVector<QRgb>& colors);
+  QVector<QRgb> colorTable() const;
+
+  /**
+   * \brief Bits per channel of the lookup table
+   *
+   * 5 (32K entries, the default) or 6 (256K entries, slower to build)
+   */
+  void setLookupBits(int bits);
+  int lookupBits() const;
+
+  void setDithering(Dithering dithering);
+  Dithering dithering() const;
+
+  /**
+   * \brief Maximum number of threads, 0 (the default) uses all the cores
+   */
+  void setThreadCount(int threads);
+  int threadCount() const;
+
+  /**
+   * \brief Index in colorTable() of the color closest to \p rgb
+   * \returns -1 if the palette is empty
+   */
+  int nearestIndex(QRgb rgb) const;
+
+  /**
+   * \brief Maps \p image onto the palette
+   *
+   * IndexedOutput falls back to RgbOutput for palettes with more than 256
+   * colors. Alpha is ignored.
+   * \returns A null image if the palette or \p image are empty
+   */
+  QImage remap(const QImage& image, OutputFormat format = IndexedOutput) const;
+
+  /**
+   * \brief Maps \p image onto the palette without building an image
+   * \returns The index in colorTable() of each pixel, row by row
+   */
+  QVector<quint16> indices(const QImage& image) const;
+
+private:
+  class Private;
+  Private* p;
+};
+
+} // namespace color_widgets
+
+#endif // COLOR_WIDGETS_IMAGE_REMAPPER_HPP
@@ -0,0 +1,106 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef COLOR_WIDGETS_PALETTE_SOURCE_HPP
+#define COLOR_WIDGETS_PALETTE_SOURCE_HPP
+
+#include "colorwidgets_global.hpp"
+#include "gradient_editor.hpp"
+
+#include <QColor>
+#include <QGradient>
+#include <QVector>
+
+#include <functional>
+
+namespace color_widgets
+{
+
+/**
+ * \brief Colors computed on demand, which a ColorPalette can read in place
+ * of stored colors
+ *
+ * The generator is called for blocks of consecutive colors. The last few
+ * blocks are cached, so reading colors in order calls it once per block.
+ * Lookups lock the cache, so a source can be read from several threads.
+ * Copies share the generator but not the cache.
+ */
+class QCP_EXPORT PaletteSource
+{
+public:
+  /**
+   * \brief Fills \p out with \p count colors, starting from index \p first
+   */
+  using Generator = std::function<void(int first, int count, QRgb* out)>;
+
+  PaletteSource(const Generator& generator, int count);
+  PaletteSource(const PaletteSource& other);
+  PaletteSource& operator=(const PaletteSource& other);
+  ~PaletteSource();
+  PaletteSource(PaletteSource&& other);
+  PaletteSource& operator=(PaletteSource&& other);
+
+  /**
+   * \brief Number of colors
+   */
+  int count() const;
+
+  /**
+   * \brief Color at the given index
+   * \pre 0 <= index < count()
+   */
+  QRgb rgbAt(int index) const;
+
+  /**
+   * \brief Colors evenly sampled from a gradient, including both ends
+   * \param stops Gradient stops, sorted by position
+   *
+   * Blocks of colors are interpolated in a single pass, as sampleGradient().
+   */
+  static PaletteSource fromGradient(
+      const QGradientStops& stops,
+      int count,
+      GradientEditor::Interpolation interpolation = GradientEditor::Rgb);
+
+  /**
+   * \brief Colors with evenly spaced hues and the same saturation and value
+   */
+  static PaletteSource hueSweep(int count, qreal saturation = 1, qreal value = 1);
+
+  /**
+   * \brief Samples \p count evenly spaced colors from a gradient, including both ends
+   * \param stops Gradient stops, sorted by position
+   *
+   * Colors are interpolated as GradientEditor shows them.
+   */
+  static QVector<QRgb> sampleGradient(
+      const QGradientStops& stops,
+      int count,
+      GradientEditor::Interpolation interpolation = GradientEditor::Rgb);
+
+private:
+  class Private;
+  Private* p;
+};
+
+} // namespace color_widgets
+
+#endif // COLOR_WIDGETS_PALETTE_SOURCE_HPP
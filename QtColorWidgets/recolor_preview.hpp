@@ -0,0 +1,96 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef COLOR_WIDGETS_RECOLOR_PREVIEW_HPP
+#define COLOR_WIDGETS_RECOLOR_PREVIEW_HPP
+
+#include "color_palette.hpp"
+#include "image_remapper.hpp"
+
+#include <QWidget>
+
+namespace color_widgets
+{
+
+/**
+ * \brief Shows an image recolored with the colors of a palette
+ *
+ * Each pixel of the image is mapped once to the nearest palette color, after
+ * that the pixels follow the palette entry they have been mapped to: when a
+ * color of the palette changes only the pixels using it are redrawn, so
+ * editing the palette stays interactive on large images.
+ * The image is remapped when colors are added or removed.
+ */
+class QCP_EXPORT RecolorPreview final : public QWidget
+{
+  W_OBJECT(RecolorPreview)
+
+public:
+  explicit RecolorPreview(QWidget* parent = nullptr);
+  ~RecolorPreview() override;
+
+  QSize sizeHint() const Q_DECL_OVERRIDE;
+
+  QImage image() const;
+
+  /**
+   * \brief The image with the palette colors applied, at full resolution
+   */
+  QImage recoloredImage() const;
+
+  ColorPalette* colorPalette() const;
+
+  /**
+   * \brief Palette used to recolor the image
+   *
+   * The preview follows the changes to \p palette, which must outlive it or
+   * be unset before being deleted.
+   */
+  void setColorPalette(ColorPalette* palette);
+
+  ImageRemapper::Dithering dithering() const;
+
+  /**
+   * \brief Dithering used when mapping the image to the palette
+   */
+  void setDithering(ImageRemapper::Dithering dithering);
+
+  void setImage(const QImage& image);
+  W_SLOT(setImage)
+
+  void imageChanged(const QImage& image) W_SIGNAL(imageChanged, image);
+
+  /**
+   * \brief Image to be recolored
+   */
+  W_PROPERTY(QImage, image READ image WRITE setImage NOTIFY imageChanged)
+
+protected:
+  void paintEvent(QPaintEvent* event) Q_DECL_OVERRIDE;
+
+private:
+  class Private;
+  Private* p;
+};
+
+} // namespace color_widgets
+
+#endif // COLOR_WIDGETS_RECOLOR_PREVIEW_HPP
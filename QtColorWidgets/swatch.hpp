@@ -78,6 +78,8 @@ public:
   QPen selection() const;
   int margin() const;
   QColor emptyColor() const;
+  QColor contrastBackground() const;
+  qreal minimumContrast() const;
 
   int forcedRows() const;
   int forcedColumns() const;
@@ -108,6 +110,10 @@ public:
   W_SLOT(setForcedColumns)
   void setReadOnly(bool readOnly);
   W_SLOT(setReadOnly)
+  void setContrastBackground(const QColor& contrastBackground);
+  W_SLOT(setContrastBackground)
+  void setMinimumContrast(qreal minimumContrast);
+  W_SLOT(setMinimumContrast)
   /**
    * \brief Remove the currently seleceted color
    **/
@@ -128,6 +134,10 @@ public:
   void selectionChanged(const QPen& selection) W_SIGNAL(selectionChanged, selection);
   void marginChanged(const int& margin) W_SIGNAL(marginChanged, margin);
   void emptyColorChanged(const QColor& emptyColor) W_SIGNAL(emptyColorChanged, emptyColor);
+  void contrastBackgroundChanged(const QColor& contrastBackground)
+      W_SIGNAL(contrastBackgroundChanged, contrastBackground);
+  void minimumContrastChanged(qreal minimumContrast)
+      W_SIGNAL(minimumContrastChanged, minimumContrast);
 
 protected:
   bool event(QEvent* event) Q_DECL_OVERRIDE;
@@ -217,6 +227,25 @@ protected:
    */
   W_PROPERTY(bool, readOnly READ readOnly WRITE setReadOnly NOTIFY readOnlyChanged)
 
+  /**
+   * \brief Background the colors are checked against for legibility
+   *
+   * Colors with a WCAG contrast ratio below minimumContrast against it are
+   * marked with a black or white stroke, whichever contrasts the most with
+   * the swatch. An invalid color disables the check.
+   */
+  W_PROPERTY(
+      QColor,
+      contrastBackground READ contrastBackground WRITE setContrastBackground NOTIFY
+          contrastBackgroundChanged)
+
+  /**
+   * \brief Minimum contrast ratio against contrastBackground, defaults to 4.5 (WCAG AA)
+   */
+  W_PROPERTY(
+      qreal,
+      minimumContrast READ minimumContrast WRITE setMinimumContrast NOTIFY minimumContrastChanged)
+
 private:
   class Private;
   Private* p;
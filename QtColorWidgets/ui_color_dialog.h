@@ -29,6 +29,7 @@
 #include "color_line_edit.hpp"
 #include "color_preview.hpp"
 #include "color_wheel.hpp"
+#include "component_slider.hpp"
 #include "gradient_slider.hpp"
 #include "hue_slider.hpp"
 
@@ -43,20 +44,20 @@ public:
     color_widgets::ColorWheel *wheel;
     color_widgets::ColorPreview *preview;
     QGridLayout *gridLayout;
-    color_widgets::GradientSlider *slide_value;
+    color_widgets::ComponentSlider *slide_value;
     QLabel *label_7;
     QLabel *label_6;
-    color_widgets::GradientSlider *slide_saturation;
+    color_widgets::ComponentSlider *slide_saturation;
     QLabel *label_8;
     QLabel *label_3;
-    color_widgets::GradientSlider *slide_alpha;
-    color_widgets::GradientSlider *slide_red;
-    color_widgets::GradientSlider *slide_green;
+    color_widgets::ComponentSlider *slide_alpha;
+    color_widgets::ComponentSlider *slide_red;
+    color_widgets::ComponentSlider *slide_green;
     QLabel *label_5;
     QLabel *label_2;
     QLabel *label_alpha;
     QLabel *label;
-    color_widgets::GradientSlider *slide_blue;
+    color_widgets::ComponentSlider *slide_blue;
     QSpinBox *spin_hue;
     QSpinBox *spin_saturation;
     QSpinBox *spin_value;
@@ -116,10 +117,12 @@ public:
         gridLayout = new QGridLayout();
         gridLayout->setSpacing(6);
         gridLayout->setObjectName(QStringLiteral("gridLayout"));
-        slide_value = new color_widgets::GradientSlider(ColorDialog);
+        slide_value = new color_widgets::ComponentSlider(ColorDialog);
         slide_value->setObjectName(QStringLiteral("slide_value"));
         slide_value->setMaximum(255);
         slide_value->setOrientation(Qt::Horizontal);
+        slide_value->setModel(color_widgets::ComponentSlider::Hsv);
+        slide_value->setComponent(color_widgets::ComponentSlider::Value);
 
         gridLayout->addWidget(slide_value, 2, 1, 1, 1);
 
@@ -133,10 +136,12 @@ public:
 
         gridLayout->addWidget(label_6, 0, 0, 1, 1);
 
-        slide_saturation = new color_widgets::GradientSlider(ColorDialog);
+        slide_saturation = new color_widgets::ComponentSlider(ColorDialog);
         slide_saturation->setObjectName(QStringLiteral("slide_saturation"));
         slide_saturation->setMaximum(255);
         slide_saturation->setOrientation(Qt::Horizontal);
+        slide_saturation->setModel(color_widgets::ComponentSlider::Hsv);
+        slide_saturation->setComponent(color_widgets::ComponentSlider::Saturation);
 
         gridLayout->addWidget(slide_saturation, 1, 1, 1, 1);
 
@@ -150,24 +155,30 @@ public:
 
         gridLayout->addWidget(label_3, 6, 0, 1, 1);
 
-        slide_alpha = new color_widgets::GradientSlider(ColorDialog);
+        slide_alpha = new color_widgets::ComponentSlider(ColorDialog);
         slide_alpha->setObjectName(QStringLiteral("slide_alpha"));
         slide_alpha->setMaximum(255);
         slide_alpha->setOrientation(Qt::Horizontal);
+        slide_alpha->setModel(color_widgets::ComponentSlider::Rgb);
+        slide_alpha->setComponent(color_widgets::ComponentSlider::Alpha);
 
         gridLayout->addWidget(slide_alpha, 8, 1, 1, 1);
 
-        slide_red = new color_widgets::GradientSlider(ColorDialog);
+        slide_red = new color_widgets::ComponentSlider(ColorDialog);
         slide_red->setObjectName(QStringLiteral("slide_red"));
         slide_red->setMaximum(255);
         slide_red->setOrientation(Qt::Horizontal);
+        slide_red->setModel(color_widgets::ComponentSlider::Rgb);
+        slide_red->setComponent(color_widgets::ComponentSlider::Red);
 
         gridLayout->addWidget(slide_red, 4, 1, 1, 1);
 
-        slide_green = new color_widgets::GradientSlider(ColorDialog);
+        slide_green = new color_widgets::ComponentSlider(ColorDialog);
         slide_green->setObjectName(QStringLiteral("slide_green"));
         slide_green->setMaximum(255);
         slide_green->setOrientation(Qt::Horizontal);
+        slide_green->setModel(color_widgets::ComponentSlider::Rgb);
+        slide_green->setComponent(color_widgets::ComponentSlider::Green);
 
         gridLayout->addWidget(slide_green, 5, 1, 1, 1);
 
@@ -191,10 +202,12 @@ public:
 
         gridLayout->addWidget(label, 4, 0, 1, 1);
 
-        slide_blue = new color_widgets::GradientSlider(ColorDialog);
+        slide_blue = new color_widgets::ComponentSlider(ColorDialog);
         slide_blue->setObjectName(QStringLiteral("slide_blue"));
         slide_blue->setMaximum(255);
         slide_blue->setOrientation(Qt::Horizontal);
+        slide_blue->setModel(color_widgets::ComponentSlider::Rgb);
+        slide_blue->setComponent(color_widgets::ComponentSlider::Blue);
 
         gridLayout->addWidget(slide_blue, 6, 1, 1, 1);
 
@@ -275,6 +288,7 @@ public:
         font.setFamily(QStringLiteral("Monospace"));
         edit_hex->setFont(font);
         edit_hex->setShowAlpha(true);
+        edit_hex->setCompleteNames(true);
 
         gridLayout->addWidget(edit_hex, 10, 1, 1, 2);
 
@@ -297,8 +311,8 @@ public:
         QObject::connect(slide_red, SIGNAL(valueChanged(int)), ColorDialog, SLOT(set_rgb()));
         QObject::connect(slide_green, SIGNAL(valueChanged(int)), ColorDialog, SLOT(set_rgb()));
         QObject::connect(slide_blue, SIGNAL(valueChanged(int)), ColorDialog, SLOT(set_rgb()));
-        QObject::connect(slide_alpha, SIGNAL(valueChanged(int)), ColorDialog, SLOT(update_widgets()));
-        QObject::connect(wheel, SIGNAL(colorSelected(QColor)), ColorDialog, SLOT(update_widgets()));
+        QObject::connect(slide_alpha, SIGNAL(valueChanged(int)), ColorDialog, SLOT(set_alpha()));
+        QObject::connect(wheel, SIGNAL(colorSelected(QColor)), ColorDialog, SLOT(set_wheel()));
         QObject::connect(slide_saturation, SIGNAL(valueChanged(int)), spin_saturation, SLOT(setValue(int)));
         QObject::connect(spin_saturation, SIGNAL(valueChanged(int)), slide_saturation, SLOT(setValue(int)));
         QObject::connect(slide_value, SIGNAL(valueChanged(int)), spin_value, SLOT(setValue(int)));
@@ -0,0 +1,196 @@
+#
+# Copyright (C) 2015 Mattia Basaglia
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+#
+# color_widgets_embed_palettes(<target> FILES <file.gpl>... [NAME <name>])
+#
+# Converts Gimp palette files into a header with constexpr data at build time.
+# The header is called <name>.hpp (<name> defaults to <target>_palettes) and
+# it defines an array of color_widgets::BuiltinPalette called <name>, which
+# can be passed to ColorPaletteModel::addBuiltinPalettes().
+#
+# This file is also the script run at build time to generate the header.
+#
+
+if(NOT CMAKE_SCRIPT_MODE_FILE)
+
+set(COLOR_WIDGETS_EMBED_PALETTES_SCRIPT "${CMAKE_CURRENT_LIST_FILE}" CACHE INTERNAL "")
+
+include(CMakeParseArguments)
+
+function(color_widgets_embed_palettes target)
+  cmake_parse_arguments(EMBED "" "NAME" "FILES" ${ARGN})
+  if(NOT EMBED_NAME)
+    set(EMBED_NAME "${target}_palettes")
+  endif()
+  string(MAKE_C_IDENTIFIER "${EMBED_NAME}" EMBED_NAME)
+
+  set(inputs)
+  foreach(file ${EMBED_FILES})
+    get_filename_component(file "${file}" ABSOLUTE)
+    list(APPEND inputs "${file}")
+  endforeach()
+  # Semicolons don't survive the command line
+  string(REPLACE ";" "|" input_arg "${inputs}")
+
+  set(output "${CMAKE_CURRENT_BINARY_DIR}/${EMBED_NAME}.hpp")
+  add_custom_command(
+    OUTPUT "${output}"
+    COMMAND ${CMAKE_COMMAND}
+      "-DPALETTE_FILES=${input_arg}"
+      "-DPALETTE_NAME=${EMBED_NAME}"
+      "-DPALETTE_OUTPUT=${output}"
+      -P "${COLOR_WIDGETS_EMBED_PALETTES_SCRIPT}"
+    DEPENDS ${inputs} "${COLOR_WIDGETS_EMBED_PALETTES_SCRIPT}"
+    COMMENT "Embedding palettes in ${EMBED_NAME}.hpp"
+    VERBATIM)
+
+  target_sources(${target} PRIVATE "${output}")
+  target_include_directories(${target} PRIVATE "${CMAKE_CURRENT_BINARY_DIR}")
+endfunction()
+
+return()
+endif()
+
+# Script mode: PALETTE_FILES, PALETTE_NAME and PALETTE_OUTPUT are set by the
+# custom command above
+cmake_minimum_required(VERSION 3.2)
+
+set(hex_digits "0123456789abcdef")
+function(hex_byte value out)
+  math(EXPR high "${value} / 16")
+  math(EXPR low "${value} % 16")
+  string(SUBSTRING "${hex_digits}" ${high} 1 high)
+  string(SUBSTRING "${hex_digits}" ${low} 1 low)
+  set(${out} "${high}${low}" PARENT_SCOPE)
+endfunction()
+
+# file(STRINGS) and list splitting break lines on ';' and join them across
+# unbalanced brackets, so these are replaced while the file is split in lines
+string(ASCII 1 semicolon_placeholder)
+string(ASCII 2 open_bracket_placeholder)
+string(ASCII 3 close_bracket_placeholder)
+string(ASCII 239 187 191 utf8_bom)
+
+function(read_lines file out)
+  file(READ "${file}" content)
+  string(FIND "${content}" "${utf8_bom}" bom)
+  if(bom EQUAL 0)
+    string(SUBSTRING "${content}" 3 -1 content)
+  endif()
+  string(REPLACE ";" "${semicolon_placeholder}" content "${content}")
+  string(REPLACE "[" "${open_bracket_placeholder}" content "${content}")
+  string(REPLACE "]" "${close_bracket_placeholder}" content "${content}")
+  string(REPLACE "\r" "" content "${content}")
+  string(REPLACE "\n" ";" content "${content}")
+  set(${out} "${content}" PARENT_SCOPE)
+endfunction()
+
+function(c_string value out)
+  string(REPLACE "\\" "\\\\" value "${value}")
+  string(REPLACE "\"" "\\\"" value "${value}")
+  set(${out} "\"${value}\"" PARENT_SCOPE)
+endfunction()
+
+string(REPLACE "|" ";" files "${PALETTE_FILES}")
+set(data "")
+set(palettes "")
+set(index 0)
+
+foreach(file IN LISTS files)
+  read_lines("${file}" lines)
+  list(LENGTH lines line_count)
+  if(line_count EQUAL 0)
+    message(FATAL_ERROR "${file}: not a Gimp palette")
+  endif()
+  list(GET lines 0 magic)
+  string(STRIP "${magic}" magic)
+  if(NOT magic STREQUAL "GIMP Palette")
+    message(FATAL_ERROR "${file}: not a Gimp palette")
+  endif()
+  list(REMOVE_AT lines 0)
+
+  get_filename_component(name "${file}" NAME_WE)
+  set(columns 0)
+  set(state header)
+  set(colors "")
+  set(count 0)
+
+  foreach(line IN LISTS lines)
+    string(REPLACE "${semicolon_placeholder}" ";" line "${line}")
+    string(REPLACE "${open_bracket_placeholder}" "[" line "${line}")
+    string(REPLACE "${close_bracket_placeholder}" "]" line "${line}")
+    if(state STREQUAL "header")
+      if(line MATCHES "^([^:#]+):(.*)$")
+        string(TOLOWER "${CMAKE_MATCH_1}" key)
+        string(STRIP "${CMAKE_MATCH_2}" value)
+        if(key STREQUAL "name")
+          set(name "${value}")
+        elseif(key STREQUAL "columns" AND value MATCHES "^[0-9]+$")
+          set(columns "${value}")
+        endif()
+        continue()
+      endif()
+      set(state colors)
+    endif()
+
+    if(line MATCHES "^[ \t]*#" OR line MATCHES "^[ \t]*$")
+      continue()
+    endif()
+
+    if(NOT line MATCHES "^[ \t]*([0-9]+)[ \t]+([0-9]+)[ \t]+([0-9]+)(.*)$")
+      message(FATAL_ERROR "${file}: invalid color line: ${line}")
+    endif()
+    set(rgb "0x")
+    foreach(component 1 2 3)
+      set(value ${CMAKE_MATCH_${component}})
+      if(value GREATER 255)
+        set(value 255)
+      endif()
+      hex_byte(${value} byte)
+      set(rgb "${rgb}${byte}")
+    endforeach()
+    string(STRIP "${CMAKE_MATCH_4}" color_name)
+    c_string("${color_name}" color_name)
+    set(colors "${colors}    {${rgb}, ${color_name}},\n")
+    math(EXPR count "${count} + 1")
+  endforeach()
+
+  c_string("${name}" name)
+  if(count EQUAL 0)
+    set(palettes "${palettes}    {${name}, ${columns}, nullptr, 0},\n")
+  else()
+    set(data "${data}constexpr color_widgets::BuiltinColor palette_${index}[] = {\n${colors}};\n\n")
+    set(palettes "${palettes}    {${name}, ${columns}, ${PALETTE_NAME}_data::palette_${index}, ${count}},\n")
+  endif()
+  math(EXPR index "${index} + 1")
+endforeach()
+
+file(WRITE "${PALETTE_OUTPUT}.tmp"
+"// Generated by color_widgets_embed_palettes(), do not edit
+#pragma once
+#include <QtColorWidgets/builtin_palette.hpp>
+
+namespace ${PALETTE_NAME}_data
+{
+${data}} // namespace ${PALETTE_NAME}_data
+
+constexpr color_widgets::BuiltinPalette ${PALETTE_NAME}[] = {
+${palettes}};
+")
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different
+  "${PALETTE_OUTPUT}.tmp" "${PALETTE_OUTPUT}")
+file(REMOVE "${PALETTE_OUTPUT}.tmp")
@@ -36,7 +36,19 @@ SOURCES += \
     $$PWD/src/color_utils.cpp \
     $$PWD/src/color_2d_slider.cpp \
     $$PWD/src/color_line_edit.cpp \
-    $$PWD/src/color_names.cpp
+    $$PWD/src/color_names.cpp \
+    $$PWD/src/image_remapper.cpp \
+    $$PWD/src/recolor_preview.cpp \
+    $$PWD/src/color_distance.cpp \
+    $$PWD/src/contrast_audit.cpp \
+    $$PWD/src/color_vision.cpp \
+    $$PWD/src/gamut_mapping.cpp \
+    $$PWD/src/color_state.cpp \
+    $$PWD/src/color_updates.cpp \
+    $$PWD/src/component_slider.cpp \
+    $$PWD/src/gradient_editor.cpp \
+    $$PWD/src/gradient_sampler.cpp \
+    $$PWD/src/palette_source.cpp
 
 HEADERS += \
     $$PWD/QtColorWidgets/color_wheel.hpp \
@@ -55,9 +67,27 @@ HEADERS += \
     $$PWD/QtColorWidgets/color_palette_widget.hpp \
     $$PWD/QtColorWidgets/swatch.hpp \
     $$PWD/src/color_utils.hpp \
+    $$PWD/src/color_core.hpp \
+    $$PWD/src/named_colors.hpp \
+    $$PWD/src/parallel.hpp \
+    $$PWD/src/gamut_mapping.hpp \
+    $$PWD/src/update_guard.hpp \
+    $$PWD/src/gradient_sampler.hpp \
     $$PWD/QtColorWidgets/color_2d_slider.hpp \
     $$PWD/QtColorWidgets/color_line_edit.hpp \
-    $$PWD/QtColorWidgets/color_names.hpp
+    $$PWD/QtColorWidgets/color_names.hpp \
+    $$PWD/QtColorWidgets/builtin_palette.hpp \
+    $$PWD/QtColorWidgets/image_remapper.hpp \
+    $$PWD/QtColorWidgets/recolor_preview.hpp \
+    $$PWD/QtColorWidgets/color_distance.hpp \
+    $$PWD/QtColorWidgets/contrast_audit.hpp \
+    $$PWD/QtColorWidgets/color_vision.hpp \
+    $$PWD/QtColorWidgets/color_f.hpp \
+    $$PWD/QtColorWidgets/color_state.hpp \
+    $$PWD/QtColorWidgets/color_updates.hpp \
+    $$PWD/QtColorWidgets/component_slider.hpp \
+    $$PWD/QtColorWidgets/gradient_editor.hpp \
+    $$PWD/QtColorWidgets/palette_source.hpp
 
 FORMS += \
     $$PWD/src/color_dialog.ui \
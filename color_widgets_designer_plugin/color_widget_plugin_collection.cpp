@@ -28,6 +28,7 @@
 #include "color_preview_plugin.hpp"
 #include "color_selector_plugin.hpp"
 #include "color_wheel_plugin.hpp"
+#include "component_slider_plugin.hpp"
 #include "gradient_slider_plugin.hpp"
 #include "hue_slider_plugin.hpp"
 #include "swatch_plugin.hpp"
@@ -45,6 +46,7 @@ ColorWidgets_PluginCollection::ColorWidgets_PluginCollection(QObject* parent) :
   widgets.push_back(new ColorPaletteWidget_Plugin(this));
   widgets.push_back(new Color2DSlider_Plugin(this));
   widgets.push_back(new ColorLineEdit_Plugin(this));
+  widgets.push_back(new ComponentSlider_Plugin(this));
   // add new plugins above this line
 }
 
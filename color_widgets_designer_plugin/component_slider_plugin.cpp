@@ -0,0 +1,98 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "component_slider_plugin.hpp"
+
+#include "component_slider.hpp"
+
+#include <QtPlugin>
+
+ComponentSlider_Plugin::ComponentSlider_Plugin(QObject* parent)
+    : QObject(parent), initialized(false)
+{
+}
+
+void ComponentSlider_Plugin::initialize(QDesignerFormEditorInterface*)
+{
+  if (initialized)
+    return;
+
+  initialized = true;
+}
+
+bool ComponentSlider_Plugin::isInitialized() const
+{
+  return initialized;
+}
+
+QWidget* ComponentSlider_Plugin::createWidget(QWidget* parent)
+{
+  return new color_widgets::ComponentSlider(parent);
+}
+
+QString ComponentSlider_Plugin::name() const
+{
+  return "color_widgets::ComponentSlider";
+}
+
+QString ComponentSlider_Plugin::group() const
+{
+  return "Color Widgets";
+}
+
+QIcon ComponentSlider_Plugin::icon() const
+{
+  color_widgets::ComponentSlider w;
+  w.resize(64, 16);
+  QPixmap pix(64, 64);
+  pix.fill(Qt::transparent);
+  w.render(&pix, QPoint(0, 16));
+  return QIcon(pix);
+}
+
+QString ComponentSlider_Plugin::toolTip() const
+{
+  return "Slider for one component of a color";
+}
+
+QString ComponentSlider_Plugin::whatsThis() const
+{
+  return toolTip();
+}
+
+bool ComponentSlider_Plugin::isContainer() const
+{
+  return false;
+}
+
+QString ComponentSlider_Plugin::domXml() const
+{
+
+  return "<ui language=\"c++\">\n"
+         " <widget class=\"color_widgets::ComponentSlider\" name=\"ComponentSlider\">\n"
+         " </widget>\n"
+         "</ui>\n";
+}
+
+QString ComponentSlider_Plugin::includeFile() const
+{
+  return "component_slider.hpp";
+}
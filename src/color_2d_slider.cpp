@@ -22,129 +22,319 @@
 #include "color_2d_slider.hpp"
 
 #include "color_utils.hpp"
+#include "gamut_mapping.hpp"
+#include "parallel.hpp"
+#include "update_guard.hpp"
 
 #include <QImage>
 #include <QMouseEvent>
 #include <QPainter>
 #include <QResizeEvent>
 
+#include <algorithm>
+#include <vector>
+
 namespace color_widgets
 {
 
+/// Largest OKLab a and b shown by the OkLab model
+static const float oklab_ab_range = 0.4f;
+
+/**
+ * \brief Part of a color that depends on a single axis of the plane
+ *
+ * The terms of a pixel are the sum of the terms of its column and its row,
+ * each model turns them into a color with a few multiply-adds.
+ */
+struct plane_terms
+{
+  float vec[3] = {0, 0, 0}; ///< Hue direction, or OKLab a and b for OkLab
+  float s = 0;              ///< Saturation or chroma
+  float v = 0;              ///< Value, lightness or luma
+  float lv = 0;             ///< HSL chroma for unit saturation, 1 - |2v - 1|
+
+  plane_terms& operator+=(const plane_terms& o)
+  {
+    for (int i = 0; i < 3; i++)
+      vec[i] += o.vec[i];
+    s += o.s;
+    v += o.v;
+    lv += o.lv;
+    return *this;
+  }
+};
+
+/**
+ * \brief Terms for \p channel of \p model at \p value, in [0-1]
+ */
+static plane_terms channel_terms(Color2DSlider::Model model, int channel, float value)
+{
+  plane_terms t;
+
+  if (model == Color2DSlider::OkLab)
+  {
+    if (channel == 2)
+      t.v = value;
+    else
+      t.vec[channel] = (value * 2 - 1) * oklab_ab_range;
+    return t;
+  }
+
+  if (channel == 0)
+  {
+    detail::rgb_f f = detail::rgb_from_hue_chroma(value >= 1 ? value - 1 : value, 1);
+    // Offset so each model only needs to scale the hue direction
+    float offset = 1;
+    if (model == Color2DSlider::Hsl)
+      offset = 0.5f;
+    else if (model == Color2DSlider::Lch)
+      offset = detail::color_luma(f);
+    t.vec[0] = f.r - offset;
+    t.vec[1] = f.g - offset;
+    t.vec[2] = f.b - offset;
+  }
+  else if (channel == 1)
+  {
+    t.s = value;
+  }
+  else
+  {
+    t.v = value;
+    t.lv = 1 - qAbs(2 * value - 1);
+  }
+  return t;
+}
+
+static int to_8bit(float value)
+{
+  return int(detail::math::clamp(value, 0.f, 1.f) * 255 + 0.5f);
+}
+
+static QRgb pixel_hsv(const plane_terms& t, const quint8*)
+{
+  float vs = t.v * t.s;
+  return qRgb(
+      to_8bit(t.v + vs * t.vec[0]), to_8bit(t.v + vs * t.vec[1]), to_8bit(t.v + vs * t.vec[2]));
+}
+
+static QRgb pixel_hsl(const plane_terms& t, const quint8*)
+{
+  float chroma = t.s * t.lv;
+  return qRgb(
+      to_8bit(t.v + chroma * t.vec[0]),
+      to_8bit(t.v + chroma * t.vec[1]),
+      to_8bit(t.v + chroma * t.vec[2]));
+}
+
+static QRgb pixel_lch(const plane_terms& t, const quint8*)
+{
+  return qRgb(
+      to_8bit(t.v + t.s * t.vec[0]), to_8bit(t.v + t.s * t.vec[1]), to_8bit(t.v + t.s * t.vec[2]));
+}
+
+/**
+ * \brief Renders a plane from the terms of its columns and rows
+ */
+template<QRgb (*Pixel)(const plane_terms&, const quint8*)>
+static void render_plane(
+    const std::vector<plane_terms>& columns, const std::vector<plane_terms>& rows, QImage& image)
+{
+  const quint8* encode = detail::srgb_encode_table();
+  int width = int(columns.size());
+  uchar* bits = image.bits();
+  qptrdiff stride = image.bytesPerLine();
+  int size = int(qint64(width) * image.height());
+
+  detail::parallel_for(
+      0, image.height(), detail::thread_count(0, size / 65536), [&](int from, int to) {
+        for (int y = from; y < to; y++)
+        {
+          QRgb* line = reinterpret_cast<QRgb*>(bits + y * stride);
+          for (int x = 0; x < width; x++)
+          {
+            plane_terms t = columns[x];
+            t += rows[y];
+            line[x] = Pixel(t, encode);
+          }
+        }
+      });
+}
+
+using plane_kernel = void (*)(
+    const std::vector<plane_terms>&, const std::vector<plane_terms>&, QImage&);
+
+/// Indexed by Color2DSlider::Model, OkLab uses render_oklab_plane()
+static const plane_kernel plane_kernels[] = {
+    render_plane<pixel_hsv>,
+    render_plane<pixel_hsl>,
+    render_plane<pixel_lch>,
+};
+
+/**
+ * \brief Renders the OkLab plane, reducing the chroma of colors out of gamut
+ * \param overlay Whether to mark the colors out of gamut with stripes
+ */
+static void render_oklab_plane(
+    const std::vector<plane_terms>& columns,
+    const std::vector<plane_terms>& rows,
+    QImage& image,
+    bool overlay)
+{
+  int width = int(columns.size());
+  uchar* bits = image.bits();
+  qptrdiff stride = image.bytesPerLine();
+  int size = int(qint64(width) * image.height());
+
+  detail::parallel_for(
+      0, image.height(), detail::thread_count(0, size / 65536), [&](int from, int to) {
+        std::vector<float> l(width), a(width), b(width);
+        std::vector<quint8> out_of_gamut(width);
+        for (int y = from; y < to; y++)
+        {
+          for (int x = 0; x < width; x++)
+          {
+            plane_terms t = columns[x];
+            t += rows[y];
+            l[x] = t.v;
+            a[x] = t.vec[0];
+            b[x] = t.vec[1];
+          }
+
+          QRgb* line = reinterpret_cast<QRgb*>(bits + y * stride);
+          detail::oklab_to_rgb(
+              l.data(), a.data(), b.data(), width, line, out_of_gamut.data(), true);
+
+          if (overlay)
+          {
+            for (int x = 0; x < width; x++)
+              if (out_of_gamut[x])
+                line[x] = detail::out_of_gamut_marker(line[x], x, y);
+          }
+        }
+      });
+}
+
 class Color2DSlider::Private
 {
 public:
-  qreal hue = 1, sat = 1, val = 1;
+  Model model = Hsv;
+  float coords[3] = {1, 1, 1}; ///< Components of the color in model, in [0-1]
   Component comp_x = Saturation;
   Component comp_y = Value;
   QImage square;
-
-  qreal PixHue(float x, float y)
+  bool updating = false;
+  bool gamut_overlay = false;
+  detail::simulated_image simulated_square;
+
+  /**
+   * \brief Components of \p c in \p model, normalized to [0-1]
+   */
+  static void to_coords(Model model, const ColorF& c, float* out)
   {
-    if (comp_x == Hue)
-      return x;
-    if (comp_y == Hue)
-      return y;
-    return hue;
-  }
-
-  qreal PixSat(float x, float y)
-  {
-    if (comp_x == Saturation)
-      return x;
-    if (comp_y == Saturation)
-      return y;
-    return sat;
+    detail::rgb_f rgb{c.r, c.g, c.b};
+    switch (model)
+    {
+      case Hsv:
+        out[0] = c.h;
+        out[1] = c.s;
+        out[2] = c.v;
+        break;
+      case Hsl:
+        out[0] = c.h;
+        out[1] = detail::color_hsl_saturation(rgb);
+        out[2] = detail::color_lightness(rgb);
+        break;
+      case Lch:
+        out[0] = c.h;
+        out[1] = detail::color_chroma(rgb);
+        out[2] = detail::color_luma(rgb);
+        break;
+      case OkLab:
+      {
+        detail::oklab lab = detail::linear_to_oklab({
+            float(detail::srgb_decode(c.r)),
+            float(detail::srgb_decode(c.g)),
+            float(detail::srgb_decode(c.b)),
+        });
+        out[0] = qBound(0.f, lab.a / oklab_ab_range / 2 + 0.5f, 1.f);
+        out[1] = qBound(0.f, lab.b / oklab_ab_range / 2 + 0.5f, 1.f);
+        out[2] = qBound(0.f, lab.l, 1.f);
+        break;
+      }
+    }
   }
 
-  qreal PixVal(float x, float y)
+  ColorF color() const
   {
-    if (comp_x == Value)
-      return x;
-    if (comp_y == Value)
-      return y;
-    return val;
+    detail::rgb_f rgb;
+    switch (model)
+    {
+      case Hsv:
+        return ColorF::fromHsvF(coords[0], coords[1], coords[2]);
+      case Hsl:
+        rgb = detail::rgb_from_hsl(coords[0], coords[1], coords[2]);
+        return ColorF::fromRgbF(rgb.r, rgb.g, rgb.b, 1, coords[0]);
+      case Lch:
+        rgb = detail::rgb_from_lch(coords[0], coords[1], coords[2]);
+        return ColorF::fromRgbF(rgb.r, rgb.g, rgb.b, 1, coords[0]);
+      case OkLab:
+      default:
+        // Same mapping as render_oklab_plane(), the clamp only removes rounding errors
+        rgb = detail::oklab_to_linear(detail::oklab_map_to_gamut({
+            coords[2],
+            (coords[0] * 2 - 1) * oklab_ab_range,
+            (coords[1] * 2 - 1) * oklab_ab_range,
+        }));
+        return ColorF::fromRgbF(
+            float(detail::srgb_encode(detail::math::clamp(rgb.r, 0.f, 1.f))),
+            float(detail::srgb_encode(detail::math::clamp(rgb.g, 0.f, 1.f))),
+            float(detail::srgb_encode(detail::math::clamp(rgb.b, 0.f, 1.f))));
+    }
   }
 
   void renderSquare(const QSize& size)
   {
     square = QImage(size, QImage::Format_RGB32);
+    if (size.isEmpty())
+      return;
 
-    for (int y = 0; y < size.height(); ++y)
+    // Each component goes to the axis showing it or is added to the columns
+    std::vector<plane_terms> columns(size.width()), rows(size.height());
+    for (int channel = 0; channel < 3; channel++)
     {
-      qreal yfloat = 1 - qreal(y) / size.height();
-      for (int x = 0; x < size.width(); ++x)
+      if (channel == comp_x)
+      {
+        for (int x = 0; x < size.width(); ++x)
+          columns[x] += channel_terms(model, channel, float(x) / size.width());
+      }
+      else if (channel == comp_y)
       {
-        qreal xfloat = qreal(x) / size.width();
-        square.setPixel(
-            x,
-            y,
-            QColor::fromHsvF(
-                PixHue(xfloat, yfloat), PixSat(xfloat, yfloat), PixVal(xfloat, yfloat))
-                .rgb());
+        for (int y = 0; y < size.height(); ++y)
+          rows[y] += channel_terms(model, channel, 1 - float(y) / size.height());
+      }
+      else
+      {
+        plane_terms fixed = channel_terms(model, channel, coords[channel]);
+        for (auto& column : columns)
+          column += fixed;
       }
     }
+
+    if (model == OkLab)
+      render_oklab_plane(columns, rows, square, gamut_overlay);
+    else
+      plane_kernels[model](columns, rows, square);
   }
 
   QPointF selectorPos(const QSize& size)
   {
-    QPointF pt;
-    switch (comp_x)
-    {
-      case Hue:
-        pt.setX(size.width() * hue);
-        break;
-      case Saturation:
-        pt.setX(size.width() * sat);
-        break;
-      case Value:
-        pt.setX(size.width() * val);
-        break;
-    }
-    switch (comp_y)
-    {
-      case Hue:
-        pt.setY(size.height() * (1 - hue));
-        break;
-      case Saturation:
-        pt.setY(size.height() * (1 - sat));
-        break;
-      case Value:
-        pt.setY(size.height() * (1 - val));
-        break;
-    }
-    return pt;
+    return QPointF(size.width() * coords[comp_x], size.height() * (1 - coords[comp_y]));
   }
 
   void setColorFromPos(const QPoint& pt, const QSize& size)
   {
-    QPointF ptfloat(
-        qBound(0.0, qreal(pt.x()) / size.width(), 1.0),
-        qBound(0.0, 1 - qreal(pt.y()) / size.height(), 1.0));
-    switch (comp_x)
-    {
-      case Hue:
-        hue = ptfloat.x();
-        break;
-      case Saturation:
-        sat = ptfloat.x();
-        break;
-      case Value:
-        val = ptfloat.x();
-        break;
-    }
-    switch (comp_y)
-    {
-      case Hue:
-        hue = ptfloat.y();
-        break;
-      case Saturation:
-        sat = ptfloat.y();
-        break;
-      case Value:
-        val = ptfloat.y();
-        break;
-    }
+    coords[comp_x] = qBound(0.0, qreal(pt.x()) / size.width(), 1.0);
+    coords[comp_y] = qBound(0.0, 1 - qreal(pt.y()) / size.height(), 1.0);
   }
 };
 
@@ -160,7 +350,7 @@ Color2DSlider::~Color2DSlider()
 
 QColor Color2DSlider::color() const
 {
-  return QColor::fromHsvF(p->hue, p->sat, p->val);
+  return p->color().toColor();
 }
 
 QSize Color2DSlider::sizeHint() const
@@ -168,19 +358,24 @@ QSize Color2DSlider::sizeHint() const
   return {128, 128};
 }
 
+ColorF Color2DSlider::colorF() const
+{
+  return p->color();
+}
+
 qreal Color2DSlider::hue() const
 {
-  return p->hue;
+  return p->color().h;
 }
 
 qreal Color2DSlider::saturation() const
 {
-  return p->sat;
+  return p->color().s;
 }
 
 qreal Color2DSlider::value() const
 {
-  return p->val;
+  return p->color().v;
 }
 
 Color2DSlider::Component Color2DSlider::componentX() const
@@ -193,11 +388,37 @@ Color2DSlider::Component Color2DSlider::componentY() const
   return p->comp_y;
 }
 
+Color2DSlider::Model Color2DSlider::model() const
+{
+  return p->model;
+}
+
+bool Color2DSlider::gamutOverlay() const
+{
+  return p->gamut_overlay;
+}
+
 void Color2DSlider::setColor(const QColor& c)
 {
-  p->hue = c.hsvHueF();
-  p->sat = c.saturationF();
-  p->val = c.valueF();
+  ColorF f = ColorF::fromColor(c);
+  // Grays keep the current hue
+  if (f.s == 0)
+    f.h = hue();
+  setColorF(f);
+}
+
+void Color2DSlider::setColorF(const ColorF& c)
+{
+  detail::update_guard guard(p->updating);
+  float coords[3];
+  Private::to_coords(p->model, c, coords);
+  bool changed = false;
+  for (int i = 0; i < 3; i++)
+    changed = changed || !detail::fuzzy_same(coords[i], p->coords[i]);
+  if (!guard.enter(changed))
+    return;
+
+  std::copy(coords, coords + 3, p->coords);
   p->renderSquare(size());
   update();
   colorChanged(color());
@@ -205,26 +426,20 @@ void Color2DSlider::setColor(const QColor& c)
 
 void Color2DSlider::setHue(qreal h)
 {
-  p->hue = h;
-  p->renderSquare(size());
-  update();
-  colorChanged(color());
+  ColorF c = p->color();
+  setColorF(ColorF::fromHsvF(h, c.s, c.v));
 }
 
 void Color2DSlider::setSaturation(qreal s)
 {
-  p->sat = s;
-  p->renderSquare(size());
-  update();
-  colorChanged(color());
+  ColorF c = p->color();
+  setColorF(ColorF::fromHsvF(c.h, s, c.v));
 }
 
 void Color2DSlider::setValue(qreal v)
 {
-  p->val = v;
-  p->renderSquare(size());
-  update();
-  colorChanged(color());
+  ColorF c = p->color();
+  setColorF(ColorF::fromHsvF(c.h, c.s, v));
 }
 
 void Color2DSlider::setComponentX(Color2DSlider::Component componentX)
@@ -249,13 +464,40 @@ void Color2DSlider::setComponentY(Color2DSlider::Component componentY)
   }
 }
 
+void Color2DSlider::setModel(Color2DSlider::Model model)
+{
+  if (model != p->model)
+  {
+    ColorF c = p->color();
+    p->model = model;
+    Private::to_coords(model, c, p->coords);
+    p->renderSquare(size());
+    update();
+    modelChanged(p->model);
+  }
+}
+
+void Color2DSlider::setGamutOverlay(bool gamutOverlay)
+{
+  if (gamutOverlay == p->gamut_overlay)
+    return;
+
+  p->gamut_overlay = gamutOverlay;
+  gamutOverlayChanged(gamutOverlay);
+  if (p->model == OkLab)
+  {
+    p->renderSquare(size());
+    update();
+  }
+}
+
 void Color2DSlider::paintEvent(QPaintEvent*)
 {
   QPainter painter(this);
   painter.setRenderHint(QPainter::Antialiasing);
-  painter.drawImage(0, 0, p->square);
+  painter.drawImage(0, 0, p->simulated_square(p->square));
 
-  painter.setPen(QPen(p->val > 0.5 ? Qt::black : Qt::white, 3));
+  painter.setPen(QPen(p->color().v > 0.5 ? Qt::black : Qt::white, 3));
   painter.setBrush(Qt::NoBrush);
   painter.drawEllipse(
       p->selectorPos(size()),
@@ -0,0 +1,563 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+#include <cstdint>
+
+// Color conversions on plain values, with no dependency on Qt.
+// Everything here is constexpr so the same code builds lookup tables at
+// compile time and backs the runtime conversions.
+
+namespace color_widgets
+{
+namespace detail
+{
+
+/**
+ * \brief RGB color with float components in [0-1]
+ */
+struct rgb_f
+{
+  float r, g, b;
+};
+
+/**
+ * \brief Color in the OKLab perceptual color space
+ */
+struct oklab
+{
+  float l, a, b;
+};
+
+/**
+ * \brief Color in the CIE L*a*b* color space (D65 white point)
+ */
+struct cielab
+{
+  float l, a, b;
+};
+
+namespace math
+{
+
+constexpr double ln2 = 0.6931471805599453;
+
+template<class T>
+constexpr T abs(T x)
+{
+  return x < 0 ? -x : x;
+}
+
+template<class T>
+constexpr T min(T a, T b)
+{
+  return b < a ? b : a;
+}
+
+template<class T>
+constexpr T max(T a, T b)
+{
+  return a < b ? b : a;
+}
+
+template<class T>
+constexpr T clamp(T value, T low, T high)
+{
+  return value < low ? low : (high < value ? high : value);
+}
+
+/**
+ * \brief Natural logarithm, \p x must be positive
+ */
+constexpr double log(double x)
+{
+  int exponent = 0;
+  while (x > 2)
+  {
+    x /= 2;
+    exponent++;
+  }
+  while (x < 1)
+  {
+    x *= 2;
+    exponent--;
+  }
+
+  // log(x) = 2 atanh((x-1)/(x+1)), which converges quickly for x in [1, 2]
+  double y = (x - 1) / (x + 1);
+  double y2 = y * y;
+  double term = y;
+  double sum = 0;
+  for (int n = 1; n < 40; n += 2)
+  {
+    sum += term / n;
+    term *= y2;
+  }
+  return 2 * sum + exponent * ln2;
+}
+
+constexpr double exp(double x)
+{
+  // x = k ln(2) + r with |r| <= ln(2) / 2
+  int k = int(x / ln2 + (x < 0 ? -0.5 : 0.5));
+  double r = x - k * ln2;
+  double term = 1;
+  double sum = 1;
+  for (int n = 1; n < 20; n++)
+  {
+    term *= r / n;
+    sum += term;
+  }
+  for (; k > 0; k--)
+    sum *= 2;
+  for (; k < 0; k++)
+    sum /= 2;
+  return sum;
+}
+
+/**
+ * \brief \p base raised to \p exponent, 0 for non-positive bases
+ */
+constexpr double pow(double base, double exponent)
+{
+  return base <= 0 ? 0 : exp(exponent * log(base));
+}
+
+constexpr double cbrt(double x)
+{
+  if (x == 0)
+    return 0;
+  if (x < 0)
+    return -cbrt(-x);
+
+  double scale = 1;
+  while (x > 1)
+  {
+    x /= 8;
+    scale *= 2;
+  }
+  while (x < 0.125)
+  {
+    x *= 8;
+    scale /= 2;
+  }
+
+  // Newton's method from a linear approximation on [1/8, 1]
+  double y = 0.5 + 0.5 * x;
+  for (int i = 0; i < 6; i++)
+    y -= (y * y * y - x) / (3 * y * y);
+  return y * scale;
+}
+
+/**
+ * \brief Remainder of \p x / 2, for non-negative \p x
+ */
+constexpr float mod2(float x)
+{
+  return x - 2 * int(x / 2);
+}
+
+} // namespace math
+
+constexpr float color_max(const rgb_f& c)
+{
+  return math::max(c.r, math::max(c.g, c.b));
+}
+
+constexpr float color_min(const rgb_f& c)
+{
+  return math::min(c.r, math::min(c.g, c.b));
+}
+
+constexpr float color_chroma(const rgb_f& c)
+{
+  return color_max(c) - color_min(c);
+}
+
+/**
+ * \brief Y'601 luma
+ */
+constexpr float color_luma(const rgb_f& c)
+{
+  return 0.30f * c.r + 0.59f * c.g + 0.11f * c.b;
+}
+
+/**
+ * \brief HSL lightness
+ */
+constexpr float color_lightness(const rgb_f& c)
+{
+  return (color_max(c) + color_min(c)) / 2;
+}
+
+/**
+ * \brief HSL saturation
+ */
+constexpr float color_hsl_saturation(const rgb_f& c)
+{
+  float l = color_lightness(c);
+  if (l <= 1e-6f || l >= 1 - 1e-6f)
+    return 0;
+  return math::min(color_chroma(c) / (1 - math::abs(2 * l - 1)), 1.f);
+}
+
+/**
+ * \brief Hue in [0-1), 0 for grays
+ */
+constexpr float color_hue(const rgb_f& c)
+{
+  float max = color_max(c);
+  float chroma = color_chroma(c);
+  if (chroma <= 0)
+    return 0;
+
+  float h = 0;
+  if (max == c.r)
+    h = (c.g - c.b) / chroma;
+  else if (max == c.g)
+    h = (c.b - c.r) / chroma + 2;
+  else
+    h = (c.r - c.g) / chroma + 4;
+
+  h /= 6;
+  return h < 0 ? h + 1 : h;
+}
+
+/**
+ * \brief Color with the given hue and chroma with its minimum component at 0
+ */
+constexpr rgb_f rgb_from_hue_chroma(float hue, float chroma)
+{
+  float h1 = hue * 6;
+  if (h1 < 0)
+    return {0, 0, 0};
+
+  float x = chroma * (1 - math::abs(math::mod2(h1) - 1));
+  if (h1 < 1)
+    return {chroma, x, 0};
+  if (h1 < 2)
+    return {x, chroma, 0};
+  if (h1 < 3)
+    return {0, chroma, x};
+  if (h1 < 4)
+    return {0, x, chroma};
+  if (h1 < 5)
+    return {x, 0, chroma};
+  if (h1 < 6)
+    return {chroma, 0, x};
+  return {0, 0, 0};
+}
+
+constexpr rgb_f rgb_offset_clamped(const rgb_f& c, float m)
+{
+  return {
+      math::clamp(c.r + m, 0.f, 1.f),
+      math::clamp(c.g + m, 0.f, 1.f),
+      math::clamp(c.b + m, 0.f, 1.f),
+  };
+}
+
+/**
+ * \brief Color from hue, chroma and Y'601 luma, all in [0-1]
+ */
+constexpr rgb_f rgb_from_lch(float hue, float chroma, float luma)
+{
+  rgb_f col = rgb_from_hue_chroma(hue, chroma);
+  return rgb_offset_clamped(col, luma - color_luma(col));
+}
+
+/**
+ * \brief Color from HSL components, all in [0-1]
+ */
+constexpr rgb_f rgb_from_hsl(float hue, float sat, float lig)
+{
+  float chroma = (1 - math::abs(2 * lig - 1)) * sat;
+  return rgb_offset_clamped(rgb_from_hue_chroma(hue, chroma), lig - chroma / 2);
+}
+
+/**
+ * \brief Largest chroma with the given hue and Y'601 luma that fits in RGB
+ */
+constexpr float lch_max_chroma(float hue, float luma)
+{
+  float unit_luma = color_luma(rgb_from_hue_chroma(hue, 1));
+  if (unit_luma <= 0 || unit_luma >= 1)
+    return 1;
+  float max = math::min(luma / unit_luma, (1 - luma) / (1 - unit_luma));
+  return math::clamp(max, 0.f, 1.f);
+}
+
+/**
+ * \brief Like rgb_from_lch() but out of gamut colors have their chroma reduced
+ * instead of their channels clipped, so hue and luma are preserved
+ */
+constexpr rgb_f rgb_from_lch_mapped(float hue, float chroma, float luma)
+{
+  return rgb_from_lch(hue, math::min(chroma, lch_max_chroma(hue, luma)), luma);
+}
+
+/**
+ * \brief sRGB transfer function, from encoded to linear light
+ */
+constexpr double srgb_decode(double c)
+{
+  return c <= 0.04045 ? c / 12.92 : math::pow((c + 0.055) / 1.055, 2.4);
+}
+
+/**
+ * \brief Inverse sRGB transfer function, from linear light to encoded
+ */
+constexpr double srgb_encode(double c)
+{
+  return c <= 0.0031308 ? c * 12.92 : 1.055 * math::pow(c, 1 / 2.4) - 0.055;
+}
+
+struct srgb_linear_table
+{
+  float values[256];
+};
+
+constexpr srgb_linear_table build_srgb_linear_table()
+{
+  srgb_linear_table table{};
+  for (int i = 0; i < 256; i++)
+    table.values[i] = float(srgb_decode(i / 255.));
+  return table;
+}
+
+/**
+ * \brief Linear light value of each 8 bit sRGB channel value
+ */
+constexpr srgb_linear_table srgb_linear = build_srgb_linear_table();
+
+/**
+ * \brief Converts an sRGB 8 bit channel to linear light in [0-1]
+ */
+constexpr float srgb_to_linear(int channel)
+{
+  return srgb_linear.values[channel & 0xff];
+}
+
+/**
+ * \brief Converts linear light in [0-1] to an sRGB 8 bit channel
+ */
+constexpr int linear_to_srgb(float linear)
+{
+  return int(srgb_encode(math::clamp(linear, 0.f, 1.f)) * 255 + 0.5);
+}
+
+/**
+ * \brief Converts linear sRGB to OKLab
+ */
+constexpr oklab linear_to_oklab(const rgb_f& c)
+{
+  float l = float(math::cbrt(0.4122214708f * c.r + 0.5363325363f * c.g + 0.0514459929f * c.b));
+  float m = float(math::cbrt(0.2119034982f * c.r + 0.6806995451f * c.g + 0.1073969566f * c.b));
+  float s = float(math::cbrt(0.0883024619f * c.r + 0.2817188376f * c.g + 0.6299787005f * c.b));
+
+  return {
+      0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s,
+      1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s,
+      0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s,
+  };
+}
+
+/**
+ * \brief Converts OKLab to linear sRGB, the result may be out of gamut
+ */
+constexpr rgb_f oklab_to_linear(const oklab& c)
+{
+  float l = c.l + 0.3963377774f * c.a + 0.2158037573f * c.b;
+  float m = c.l - 0.1055613458f * c.a - 0.0638541728f * c.b;
+  float s = c.l - 0.0894841775f * c.a - 1.2914855480f * c.b;
+  l = l * l * l;
+  m = m * m * m;
+  s = s * s * s;
+
+  return {
+      +4.0767416621f * l - 3.3077115913f * m + 0.2309699292f * s,
+      -1.2684380046f * l + 2.6097574011f * m - 0.3413193965f * s,
+      -0.0041960863f * l - 0.7034186147f * m + 1.7076147010f * s,
+  };
+}
+
+/**
+ * \brief Whether all the components are in [0-1], give or take \p tolerance
+ */
+constexpr bool in_gamut(const rgb_f& c, float tolerance = 1e-4f)
+{
+  return c.r >= -tolerance && c.r <= 1 + tolerance && c.g >= -tolerance && c.g <= 1 + tolerance
+         && c.b >= -tolerance && c.b <= 1 + tolerance;
+}
+
+/**
+ * \brief Largest OKLab chroma in the sRGB gamut
+ * \param l    OKLab lightness
+ * \param a, b Unit vector pointing to the hue
+ *
+ * Binary search along chroma, chroma in sRGB is always less than 0.5.
+ */
+constexpr float oklab_max_chroma(float l, float a, float b)
+{
+  if (l <= 0 || l >= 1)
+    return 0;
+
+  float low = 0, high = 0.5f;
+  for (int i = 0; i < 16; i++)
+  {
+    float mid = (low + high) / 2;
+    if (in_gamut(oklab_to_linear({l, a * mid, b * mid})))
+      low = mid;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+/**
+ * \brief Converts 8 bit sRGB to OKLab
+ */
+constexpr oklab srgb_to_oklab(int r, int g, int b)
+{
+  return linear_to_oklab({srgb_to_linear(r), srgb_to_linear(g), srgb_to_linear(b)});
+}
+
+/**
+ * \brief CIE L*a*b* companding function
+ */
+constexpr float cielab_f(float t)
+{
+  // (6/29)^3 and 1 / (3 (6/29)^2)
+  return t > 0.008856452f ? float(math::cbrt(t)) : t * 7.787037f + 4.f / 29;
+}
+
+/**
+ * \brief Converts linear sRGB to CIE L*a*b*
+ */
+constexpr cielab linear_to_cielab(const rgb_f& c)
+{
+  float x = (0.4124564f * c.r + 0.3575761f * c.g + 0.1804375f * c.b) / 0.95047f;
+  float y = 0.2126729f * c.r + 0.7151522f * c.g + 0.0721750f * c.b;
+  float z = (0.0193339f * c.r + 0.1191920f * c.g + 0.9503041f * c.b) / 1.08883f;
+  float fx = cielab_f(x), fy = cielab_f(y), fz = cielab_f(z);
+  return {116 * fy - 16, 500 * (fx - fy), 200 * (fy - fz)};
+}
+
+/**
+ * \brief Converts 8 bit sRGB to CIE L*a*b*
+ */
+constexpr cielab srgb_to_cielab(int r, int g, int b)
+{
+  return linear_to_cielab({srgb_to_linear(r), srgb_to_linear(g), srgb_to_linear(b)});
+}
+
+namespace check
+{
+
+constexpr bool srgb_round_trip()
+{
+  for (int i = 0; i < 256; i++)
+    if (linear_to_srgb(srgb_to_linear(i)) != i)
+      return false;
+  return true;
+}
+
+constexpr int to_8bit(float c)
+{
+  return int(c * 255 + 0.5f);
+}
+
+constexpr bool hsl_round_trip()
+{
+  for (int r = 0; r < 256; r += 51)
+  {
+    for (int g = 0; g < 256; g += 51)
+    {
+      for (int b = 0; b < 256; b += 51)
+      {
+        rgb_f c{r / 255.f, g / 255.f, b / 255.f};
+        rgb_f back = rgb_from_hsl(color_hue(c), color_hsl_saturation(c), color_lightness(c));
+        if (to_8bit(back.r) != r || to_8bit(back.g) != g || to_8bit(back.b) != b)
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+constexpr bool oklab_round_trip()
+{
+  for (int r = 0; r < 256; r += 51)
+  {
+    for (int g = 0; g < 256; g += 51)
+    {
+      for (int b = 0; b < 256; b += 51)
+      {
+        rgb_f c{srgb_to_linear(r), srgb_to_linear(g), srgb_to_linear(b)};
+        rgb_f back = oklab_to_linear(linear_to_oklab(c));
+        if (math::abs(back.r - c.r) > 1e-4f || math::abs(back.g - c.g) > 1e-4f
+            || math::abs(back.b - c.b) > 1e-4f)
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+constexpr bool lch_mapping_in_gamut()
+{
+  for (int h = 0; h < 12; h++)
+  {
+    for (int y = 0; y <= 10; y++)
+    {
+      float hue = h / 12.f, luma = y / 10.f;
+      // Same as rgb_from_lch() without clipping
+      rgb_f c = rgb_from_hue_chroma(hue, lch_max_chroma(hue, luma));
+      float offset = luma - color_luma(c);
+      c = {c.r + offset, c.g + offset, c.b + offset};
+      if (!in_gamut(c) || math::abs(color_luma(c) - luma) > 1e-4f)
+        return false;
+    }
+  }
+  return true;
+}
+
+static_assert(srgb_round_trip(), "sRGB transfer round trip is not exact");
+static_assert(hsl_round_trip(), "HSL round trip is not exact");
+static_assert(oklab_round_trip(), "OKLab round trip is not accurate");
+static_assert(math::abs(srgb_to_oklab(255, 255, 255).l - 1) < 1e-4f, "OKLab white is not 1");
+static_assert(lch_mapping_in_gamut(), "LCH maximum chroma is out of gamut");
+static_assert(
+    math::abs(oklab_max_chroma(0.627955f, 0.872632f, 0.488403f) - 0.257683f) < 1e-3f,
+    "OKLab maximum chroma doesn't reach red");
+static_assert(
+    math::abs(srgb_to_cielab(255, 255, 255).l - 100) < 1e-2f
+        && math::abs(srgb_to_cielab(255, 255, 255).a) < 1e-2f
+        && math::abs(srgb_to_cielab(255, 0, 0).l - 53.24f) < 1e-2f,
+    "CIE L*a*b* conversion is not accurate");
+static_assert(
+    math::abs(math::cbrt(27.) - 3) < 1e-12 && math::abs(math::pow(2, 10) - 1024) < 1e-9,
+    "constexpr math is not accurate");
+
+} // namespace check
+
+} // namespace detail
+} // namespace color_widgets
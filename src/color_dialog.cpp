@@ -23,6 +23,7 @@
 #include "color_dialog.hpp"
 
 #include "ui_color_dialog.h"
+#include "update_guard.hpp"
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
 #include <QDesktopWidget>
@@ -46,6 +47,8 @@ public:
   ButtonMode button_mode;
   bool pick_from_screen;
   bool alpha_enabled;
+  ColorState state;
+  bool updating = false;
 
   Private() : pick_from_screen(false), alpha_enabled(true) { }
 };
@@ -66,6 +69,11 @@ ColorDialog::ColorDialog(QWidget* parent, Qt::WindowFlags f) : QDialog(parent, f
       p->ui.wheel,
       SIGNAL(displayFlagsChanged(ColorWheel::DisplayFlags)),
       SIGNAL(wheelFlagsChanged(ColorWheel::DisplayFlags)));
+
+  connect(&p->state, &ColorState::changed, this, [this](ColorState::Components changes) {
+    update_widgets(changes);
+  });
+  update_widgets(ColorState::AllComponents);
 }
 
 QSize ColorDialog::sizeHint() const
@@ -80,12 +88,17 @@ ColorWheel::DisplayFlags ColorDialog::wheelFlags() const
 
 QColor ColorDialog::color() const
 {
-  QColor col = p->ui.wheel->color();
-  if (p->alpha_enabled)
-    col.setAlpha(p->ui.slide_alpha->value());
+  QColor col = p->state.color();
+  if (!p->alpha_enabled)
+    col.setAlpha(255);
   return col;
 }
 
+ColorState* ColorDialog::colorState() const
+{
+  return &p->state;
+}
+
 void ColorDialog::setColor(const QColor& c)
 {
   p->ui.preview->setComparisonColor(c);
@@ -99,9 +112,7 @@ void ColorDialog::setColorInternal(const QColor& c)
    * \note Unlike setColor, this is used to update the current color which
    * migth differ from the final selected color
    */
-  p->ui.wheel->setColor(c);
-  p->ui.slide_alpha->setValue(c.alpha());
-  update_widgets();
+  p->state.setColor(c);
 }
 
 void ColorDialog::showColor(const QColor& c)
@@ -170,99 +181,105 @@ ColorDialog::ButtonMode ColorDialog::buttonMode() const
   return p->button_mode;
 }
 
-void ColorDialog::update_widgets()
+void ColorDialog::update_widgets(ColorState::Components changes)
 {
-  bool blocked = signalsBlocked();
-  blockSignals(true);
-  Q_FOREACH (QWidget* w, findChildren<QWidget*>())
-    w->blockSignals(true);
-
+  // Widgets updated here notify back through the slots below, which ignore
+  // them, the widget that made the change already shows it
+  detail::update_guard guard(p->updating);
+  if (!guard.enter(true))
+    return;
+
+  QObject* source = p->state.source();
+  ColorF current = p->state.colorF();
   QColor col = color();
 
-  p->ui.slide_red->setValue(col.red());
-  p->ui.spin_red->setValue(p->ui.slide_red->value());
-  p->ui.slide_red->setFirstColor(QColor(0, col.green(), col.blue()));
-  p->ui.slide_red->setLastColor(QColor(255, col.green(), col.blue()));
-
-  p->ui.slide_green->setValue(col.green());
-  p->ui.spin_green->setValue(p->ui.slide_green->value());
-  p->ui.slide_green->setFirstColor(QColor(col.red(), 0, col.blue()));
-  p->ui.slide_green->setLastColor(QColor(col.red(), 255, col.blue()));
-
-  p->ui.slide_blue->setValue(col.blue());
-  p->ui.spin_blue->setValue(p->ui.slide_blue->value());
-  p->ui.slide_blue->setFirstColor(QColor(col.red(), col.green(), 0));
-  p->ui.slide_blue->setLastColor(QColor(col.red(), col.green(), 255));
-
-  p->ui.slide_hue->setValue(qRound(p->ui.wheel->hue() * 360.0));
-  p->ui.slide_hue->setColorSaturation(p->ui.wheel->saturation());
-  p->ui.slide_hue->setColorValue(p->ui.wheel->value());
-  p->ui.spin_hue->setValue(p->ui.slide_hue->value());
-
-  p->ui.slide_saturation->setValue(qRound(p->ui.wheel->saturation() * 255.0));
-  p->ui.spin_saturation->setValue(p->ui.slide_saturation->value());
-  p->ui.slide_saturation->setFirstColor(
-      QColor::fromHsvF(p->ui.wheel->hue(), 0, p->ui.wheel->value()));
-  p->ui.slide_saturation->setLastColor(
-      QColor::fromHsvF(p->ui.wheel->hue(), 1, p->ui.wheel->value()));
-
-  p->ui.slide_value->setValue(qRound(p->ui.wheel->value() * 255.0));
-  p->ui.spin_value->setValue(p->ui.slide_value->value());
-  p->ui.slide_value->setFirstColor(
-      QColor::fromHsvF(p->ui.wheel->hue(), p->ui.wheel->saturation(), 0));
-  p->ui.slide_value->setLastColor(
-      QColor::fromHsvF(p->ui.wheel->hue(), p->ui.wheel->saturation(), 1));
-
-  QColor apha_color = col;
-  apha_color.setAlpha(0);
-  p->ui.slide_alpha->setFirstColor(apha_color);
-  apha_color.setAlpha(255);
-  p->ui.slide_alpha->setLastColor(apha_color);
-  p->ui.spin_alpha->setValue(p->ui.slide_alpha->value());
-
-  if (!p->ui.edit_hex->isModified())
+  // The wheel might not be able to represent the color exactly in its model
+  if ((changes & (ColorState::Rgb | ColorState::Hsv)) && source != p->ui.wheel)
+    p->ui.wheel->setColorF(current);
+
+  // Spin boxes follow their sliders through the connections in the ui file
+  if (changes & ColorState::Rgb)
+  {
+    for (ComponentSlider* slider : {p->ui.slide_red, p->ui.slide_green, p->ui.slide_blue})
+      if (source != slider)
+        slider->setColorF(current);
+  }
+
+  if ((changes & ColorState::Hsv) && source != p->ui.slide_hue)
+  {
+    p->ui.slide_hue->setColorSaturation(current.s);
+    p->ui.slide_hue->setColorValue(current.v);
+    p->ui.slide_hue->setValue(qRound(current.h * 360.0));
+  }
+
+  if (changes & ColorState::Hsv)
+  {
+    for (ComponentSlider* slider : {p->ui.slide_saturation, p->ui.slide_value})
+      if (source != slider)
+        slider->setColorF(current);
+  }
+
+  if ((changes & (ColorState::Rgb | ColorState::Alpha)) && source != p->ui.slide_alpha)
+    p->ui.slide_alpha->setColorF(current);
+
+  if (source != p->ui.edit_hex && !p->ui.edit_hex->isModified())
     p->ui.edit_hex->setColor(col);
 
   p->ui.preview->setColor(col);
 
-  blockSignals(blocked);
-  Q_FOREACH (QWidget* w, findChildren<QWidget*>())
-    w->blockSignals(false);
-
   colorChanged(col);
 }
 
 void ColorDialog::set_hsv()
 {
-  if (!signalsBlocked())
-  {
-    p->ui.wheel->setColor(QColor::fromHsv(
-        p->ui.slide_hue->value(), p->ui.slide_saturation->value(), p->ui.slide_value->value()));
-    update_widgets();
-  }
+  if (p->updating)
+    return;
+
+  p->state.setHsvF(
+      p->ui.slide_hue->value() / 360.f,
+      p->ui.slide_saturation->value() / 255.f,
+      p->ui.slide_value->value() / 255.f,
+      sender());
 }
 
 void ColorDialog::set_rgb()
 {
-  if (!signalsBlocked())
-  {
-    QColor col(p->ui.slide_red->value(), p->ui.slide_green->value(), p->ui.slide_blue->value());
-    if (col.saturation() == 0)
-      col = QColor::fromHsv(p->ui.slide_hue->value(), 0, col.value());
-    p->ui.wheel->setColor(col);
-    update_widgets();
-  }
+  if (p->updating)
+    return;
+
+  p->state.setRgbF(
+      p->ui.slide_red->value() / 255.f,
+      p->ui.slide_green->value() / 255.f,
+      p->ui.slide_blue->value() / 255.f,
+      sender());
+}
+
+void ColorDialog::set_alpha()
+{
+  if (!p->updating)
+    p->state.setAlphaF(p->ui.slide_alpha->value() / 255.f, sender());
+}
+
+void ColorDialog::set_wheel()
+{
+  if (p->updating)
+    return;
+
+  ColorF wheel = p->ui.wheel->colorF();
+  p->state.setHsvF(wheel.h, wheel.s, wheel.v, p->ui.wheel);
 }
 
 void ColorDialog::on_edit_hex_colorChanged(const QColor& color)
 {
-  setColorInternal(color);
+  if (!p->updating)
+    p->state.setColor(color, p->ui.edit_hex);
 }
 
 void ColorDialog::on_edit_hex_colorEditingFinished(const QColor& color)
 {
   p->ui.edit_hex->setModified(false);
-  setColorInternal(color);
+  if (!p->updating)
+    p->state.setColor(color, p->ui.edit_hex);
 }
 
 void ColorDialog::on_buttonBox_clicked(QAbstractButton* btn)
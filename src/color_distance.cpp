@@ -0,0 +1,346 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "color_distance.hpp"
+
+#include "color_utils.hpp"
+#include "parallel.hpp"
+
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#  include <xmmintrin.h>
+#  define COLOR_WIDGETS_DISTANCE_SSE
+#endif
+
+namespace color_widgets
+{
+
+namespace
+{
+/// Colors converted for a metric, one array per component
+struct Points
+{
+  QVector<float> x, y, z;
+  /// CIE L*a*b* chroma, only for CIEDE2000
+  QVector<float> chroma;
+
+  int size() const { return x.size(); }
+};
+} // namespace
+
+static const float pi = 3.14159265358979f;
+
+static float radians(float degrees)
+{
+  return degrees * pi / 180;
+}
+
+/**
+ * \brief CIEDE2000 color difference between two CIE L*a*b* colors
+ *
+ * \p c1 and \p c2 are the chroma of the two colors.
+ */
+static float ciede2000(
+    float l1, float a1, float b1, float c1, float l2, float a2, float b2, float c2)
+{
+  const float pow25_7 = 6103515625.f;
+
+  float c_mean = (c1 + c2) / 2;
+  float c_mean7 = std::pow(c_mean, 7.f);
+  float g = 0.5f * (1 - std::sqrt(c_mean7 / (c_mean7 + pow25_7)));
+  float a1p = (1 + g) * a1;
+  float a2p = (1 + g) * a2;
+  float c1p = std::sqrt(a1p * a1p + b1 * b1);
+  float c2p = std::sqrt(a2p * a2p + b2 * b2);
+
+  float h1p = b1 == 0 && a1p == 0 ? 0 : std::atan2(b1, a1p);
+  if (h1p < 0)
+    h1p += 2 * pi;
+  float h2p = b2 == 0 && a2p == 0 ? 0 : std::atan2(b2, a2p);
+  if (h2p < 0)
+    h2p += 2 * pi;
+
+  float dl = l2 - l1;
+  float dc = c2p - c1p;
+  float chroma_product = c1p * c2p;
+
+  float dh = 0;
+  float h_mean = h1p + h2p;
+  if (chroma_product != 0)
+  {
+    dh = h2p - h1p;
+    if (dh > pi)
+      dh -= 2 * pi;
+    else if (dh < -pi)
+      dh += 2 * pi;
+
+    if (std::abs(h1p - h2p) <= pi)
+      h_mean = (h1p + h2p) / 2;
+    else if (h1p + h2p < 2 * pi)
+      h_mean = (h1p + h2p + 2 * pi) / 2;
+    else
+      h_mean = (h1p + h2p - 2 * pi) / 2;
+  }
+  float dhh = 2 * std::sqrt(chroma_product) * std::sin(dh / 2);
+
+  float l_mean = (l1 + l2) / 2;
+  float cp_mean = (c1p + c2p) / 2;
+
+  float t = 1 - 0.17f * std::cos(h_mean - radians(30)) + 0.24f * std::cos(2 * h_mean)
+            + 0.32f * std::cos(3 * h_mean + radians(6))
+            - 0.20f * std::cos(4 * h_mean - radians(63));
+  float h_offset = (h_mean - radians(275)) / radians(25);
+  float d_theta = radians(30) * std::exp(-h_offset * h_offset);
+  float cp_mean7 = std::pow(cp_mean, 7.f);
+  float rc = 2 * std::sqrt(cp_mean7 / (cp_mean7 + pow25_7));
+  float l50 = (l_mean - 50) * (l_mean - 50);
+  float sl = 1 + 0.015f * l50 / std::sqrt(20 + l50);
+  float sc = 1 + 0.045f * cp_mean;
+  float sh = 1 + 0.015f * cp_mean * t;
+  float rt = -std::sin(2 * d_theta) * rc;
+
+  float tl = dl / sl;
+  float tc = dc / sc;
+  float th = dhh / sh;
+  return std::sqrt(qMax(0.f, tl * tl + tc * tc + th * th + rt * tc * th));
+}
+
+/**
+ * \brief Euclidean distances from (\p x, \p y, \p z) to the points in
+ * [\p from, \p to), stored in \p out starting from \p out[0]
+ */
+static void euclidean_kernel(
+    float x, float y, float z, const Points& points, int from, int to, float* out)
+{
+  const float* xs = points.x.constData();
+  const float* ys = points.y.constData();
+  const float* zs = points.z.constData();
+  int i = from;
+
+#ifdef COLOR_WIDGETS_DISTANCE_SSE
+  __m128 vx = _mm_set1_ps(x);
+  __m128 vy = _mm_set1_ps(y);
+  __m128 vz = _mm_set1_ps(z);
+  for (; i + 4 <= to; i += 4)
+  {
+    __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), vx);
+    __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + i), vy);
+    __m128 dz = _mm_sub_ps(_mm_loadu_ps(zs + i), vz);
+    __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+    _mm_storeu_ps(out + (i - from), _mm_sqrt_ps(sum));
+  }
+#endif
+
+  for (; i < to; i++)
+  {
+    float dx = xs[i] - x, dy = ys[i] - y, dz = zs[i] - z;
+    out[i - from] = std::sqrt(dx * dx + dy * dy + dz * dz);
+  }
+}
+
+class ColorDistance::Private
+{
+public:
+  Metric metric;
+  int threads = 0;
+
+  Points convert(const QVector<QRgb>& colors) const
+  {
+    Points points;
+    int count = colors.size();
+    points.x.resize(count);
+    points.y.resize(count);
+    points.z.resize(count);
+    if (metric == Ciede2000)
+      points.chroma.resize(count);
+
+    for (int i = 0; i < count; i++)
+    {
+      QRgb rgb = colors[i];
+      switch (metric)
+      {
+        case Rgb:
+          points.x[i] = qRed(rgb);
+          points.y[i] = qGreen(rgb);
+          points.z[i] = qBlue(rgb);
+          break;
+        case OkLab:
+        {
+          detail::oklab lab = detail::color_to_oklab(rgb);
+          points.x[i] = lab.l;
+          points.y[i] = lab.a;
+          points.z[i] = lab.b;
+          break;
+        }
+        case Cie76:
+        case Ciede2000:
+        {
+          detail::cielab lab = detail::srgb_to_cielab(qRed(rgb), qGreen(rgb), qBlue(rgb));
+          points.x[i] = lab.l;
+          points.y[i] = lab.a;
+          points.z[i] = lab.b;
+          if (metric == Ciede2000)
+            points.chroma[i] = std::sqrt(lab.a * lab.a + lab.b * lab.b);
+          break;
+        }
+      }
+    }
+    return points;
+  }
+
+  /**
+   * \brief Distances from \p points[index] to the points in [\p from, \p to)
+   */
+  void row(const Points& points, int index, int from, int to, float* out) const
+  {
+    if (metric != Ciede2000)
+    {
+      euclidean_kernel(points.x[index], points.y[index], points.z[index], points, from, to, out);
+      return;
+    }
+
+    float l = points.x[index], a = points.y[index], b = points.z[index];
+    float c = points.chroma[index];
+    for (int i = from; i < to; i++)
+      out[i - from] =
+          ciede2000(l, a, b, c, points.x[i], points.y[i], points.z[i], points.chroma[i]);
+  }
+};
+
+ColorDistance::ColorDistance(Metric metric) : p(new Private)
+{
+  p->metric = metric;
+}
+
+ColorDistance::ColorDistance(const ColorDistance& other) : p(new Private(*other.p)) { }
+
+ColorDistance& ColorDistance::operator=(const ColorDistance& other)
+{
+  *p = *other.p;
+  return *this;
+}
+
+ColorDistance::~ColorDistance()
+{
+  delete p;
+}
+
+ColorDistance::Metric ColorDistance::metric() const
+{
+  return p->metric;
+}
+
+void ColorDistance::setMetric(Metric metric)
+{
+  p->metric = metric;
+}
+
+int ColorDistance::threadCount() const
+{
+  return p->threads;
+}
+
+void ColorDistance::setThreadCount(int threads)
+{
+  p->threads = qMax(0, threads);
+}
+
+float ColorDistance::distance(QRgb a, QRgb b) const
+{
+  Points points = p->convert({a, b});
+  float out;
+  p->row(points, 0, 1, 2, &out);
+  return out;
+}
+
+float ColorDistance::distance(const QColor& a, const QColor& b) const
+{
+  return distance(a.rgb(), b.rgb());
+}
+
+QVector<float> ColorDistance::distances(QRgb color, const QVector<QRgb>& colors) const
+{
+  QVector<QRgb> all;
+  all.reserve(colors.size() + 1);
+  all.push_back(color);
+  all += colors;
+  Points points = p->convert(all);
+
+  int count = colors.size();
+  QVector<float> out(count);
+  float* data = out.data();
+  int threads = detail::thread_count(p->threads, count / 4096);
+  detail::parallel_for(1, count + 1, threads, [&](int from, int to) {
+    p->row(points, 0, from, to, data + from - 1);
+  });
+  return out;
+}
+
+QVector<float> ColorDistance::distances(const QColor& color, const ColorPalette& palette) const
+{
+  return distances(color.rgb(), palette.colorTable());
+}
+
+QVector<float> ColorDistance::matrix(const QVector<QRgb>& colors) const
+{
+  int count = colors.size();
+  // QVector allocations are limited to about 2GB
+  qint64 cells = qint64(count) * count;
+  if (cells > (std::numeric_limits<int>::max() - 64) / qint64(sizeof(float)))
+    return QVector<float>();
+
+  Points points = p->convert(colors);
+  QVector<float> out(int(cells));
+  float* data = out.data();
+
+  // Upper triangle, rows are interleaved between threads to balance the
+  // shrinking row lengths
+  int threads = detail::thread_count(p->threads, count / 64);
+  detail::run_threads(threads, [&](int thread) {
+    for (int row = thread; row < count; row += threads)
+    {
+      float* row_data = data + qptrdiff(row) * count;
+      row_data[row] = 0;
+      p->row(points, row, row + 1, count, row_data + row + 1);
+    }
+  });
+
+  // Mirror in blocks to stay in cache
+  const int block = 64;
+  detail::parallel_for(0, (count + block - 1) / block, threads, [&](int from, int to) {
+    for (int block_row = from * block; block_row < qMin(count, to * block); block_row += block)
+      for (int block_col = 0; block_col < block_row + block; block_col += block)
+        for (int row = block_row; row < qMin(count, block_row + block); row++)
+          for (int col = block_col; col < qMin(row, block_col + block); col++)
+            data[qptrdiff(row) * count + col] = data[qptrdiff(col) * count + row];
+  });
+
+  return out;
+}
+
+QVector<float> ColorDistance::matrix(const ColorPalette& palette) const
+{
+  return matrix(palette.colorTable());
+}
+
+} // namespace color_widgets
@@ -24,18 +24,140 @@
 #include "color_names.hpp"
 #include "color_utils.hpp"
 
+#include <QAbstractItemView>
+#include <QAbstractListModel>
 #include <QApplication>
+#include <QCompleter>
 #include <QDragEnterEvent>
 #include <QDropEvent>
 #include <QMimeData>
 #include <QPainter>
+#include <QPointer>
 #include <QStyleOptionFrame>
 
+#include <algorithm>
+
 #include <wobjectimpl.h>
 W_OBJECT_IMPL(color_widgets::ColorLineEdit)
 namespace color_widgets
 {
 
+/**
+ * \brief Color names offered for completion
+ *
+ * Candidates are kept sorted by their case folded name, so the ones
+ * starting with the typed text are a contiguous range found with a binary
+ * search.
+ */
+class ColorNameModel : public QAbstractListModel
+{
+public:
+  struct Candidate
+  {
+    QString folded;
+    QString name;
+    QColor color;
+  };
+
+  /// Maximum number of completions shown at once
+  static const int max_rows = 100;
+
+  using QAbstractListModel::QAbstractListModel;
+
+  int rowCount(const QModelIndex& parent = QModelIndex()) const override
+  {
+    return parent.isValid() ? 0 : last - first;
+  }
+
+  QVariant data(const QModelIndex& index, int role) const override
+  {
+    if (!index.isValid() || index.row() >= rowCount())
+      return QVariant();
+
+    const Candidate& candidate = candidates[first + index.row()];
+    switch (role)
+    {
+      case Qt::DisplayRole:
+      case Qt::EditRole:
+        return candidate.name;
+      case Qt::DecorationRole:
+        return candidate.color;
+    }
+    return QVariant();
+  }
+
+  /**
+   * \brief Replaces the candidates
+   *
+   * If more candidates have the same folded name, the first one is kept.
+   */
+  void setCandidates(QVector<Candidate> list)
+  {
+    std::stable_sort(list.begin(), list.end(), [](const Candidate& a, const Candidate& b) {
+      return a.folded < b.folded;
+    });
+    list.erase(
+        std::unique(
+            list.begin(),
+            list.end(),
+            [](const Candidate& a, const Candidate& b) { return a.folded == b.folded; }),
+        list.end());
+
+    beginResetModel();
+    candidates = std::move(list);
+    first = last = 0;
+    endResetModel();
+  }
+
+  /**
+   * \brief Shows only the candidates starting with \p prefix
+   * \returns The number of rows
+   */
+  int setPrefix(const QString& prefix)
+  {
+    QString folded = prefix.toCaseFolded();
+    auto begin = std::lower_bound(
+        candidates.cbegin(), candidates.cend(), folded, [](const Candidate& c, const QString& s) {
+          return c.folded < s;
+        });
+    auto end = std::partition_point(begin, candidates.cend(), [&folded](const Candidate& c) {
+      return c.folded.startsWith(folded);
+    });
+
+    int new_first = begin - candidates.cbegin();
+    int new_last = qMin<int>(new_first + max_rows, end - candidates.cbegin());
+    if (new_first != first || new_last != last)
+    {
+      beginResetModel();
+      first = new_first;
+      last = new_last;
+      endResetModel();
+    }
+    return last - first;
+  }
+
+  /**
+   * \brief Candidate with the given name (case insensitive)
+   * \returns \b nullptr if not found
+   */
+  const Candidate* find(const QString& name) const
+  {
+    QString folded = name.toCaseFolded();
+    auto it = std::lower_bound(
+        candidates.cbegin(), candidates.cend(), folded, [](const Candidate& c, const QString& s) {
+          return c.folded < s;
+        });
+    if (it != candidates.cend() && it->folded == folded)
+      return &*it;
+    return nullptr;
+  }
+
+private:
+  QVector<Candidate> candidates;
+  int first = 0;
+  int last = 0;
+};
+
 class ColorLineEdit::Private
 {
 public:
@@ -43,6 +165,63 @@ public:
   bool show_alpha = false;
   bool preview_color = false;
   QBrush background;
+  bool complete_names = false;
+  QPointer<ColorPaletteModel> palette_model;
+  ColorNameModel* names = nullptr;
+  QCompleter* completer = nullptr;
+  bool names_dirty = true;
+
+  void updateCandidates()
+  {
+    if (!names_dirty)
+      return;
+
+    QVector<ColorNameModel::Candidate> list;
+    for (const QString& name : QColor::colorNames())
+      list.push_back({name.toCaseFolded(), name, QColor(name)});
+
+    if (palette_model)
+    {
+      for (int i = 0; i < palette_model->count(); i++)
+      {
+        const ColorPalette& palette = palette_model->palette(i);
+        for (int j = 0; j < palette.count(); j++)
+        {
+          QString name = palette.nameAt(j);
+          if (!name.isEmpty())
+            list.push_back({name.toCaseFolded(), name, palette.colorAt(j)});
+        }
+      }
+    }
+
+    names->setCandidates(std::move(list));
+    names_dirty = false;
+  }
+
+  /**
+   * \brief Parses \p text as a color string or a known color name
+   */
+  QColor colorFromText(const QString& text)
+  {
+    QColor color = color_widgets::colorFromString(text, show_alpha);
+    if (!color.isValid() && complete_names && palette_model)
+    {
+      updateCandidates();
+      if (const ColorNameModel::Candidate* candidate = names->find(text.trimmed()))
+        color = candidate->color;
+    }
+    return color;
+  }
+
+  void complete(const QString& text)
+  {
+    updateCandidates();
+    QString prefix = text.trimmed();
+    if (!prefix.isEmpty() && names->setPrefix(prefix) > 0)
+      completer->complete();
+    else
+      completer->popup()->hide();
+  }
 
   bool customAlpha() { return preview_color && show_alpha && color.alpha() < 255; }
 
@@ -75,7 +254,7 @@ ColorLineEdit::ColorLineEdit(QWidget* parent) : QLineEdit(parent), p(new Private
           colorChanged(color);
   });*/
   connect(this, &QLineEdit::textEdited, [this](const QString& text) {
-    QColor color = color_widgets::colorFromString(text, p->show_alpha);
+    QColor color = p->colorFromText(text);
     if (color.isValid())
     {
       p->color = color;
@@ -83,9 +262,11 @@ ColorLineEdit::ColorLineEdit(QWidget* parent) : QLineEdit(parent), p(new Private
       colorEdited(color);
       colorChanged(color);
     }
+    if (p->complete_names)
+      p->complete(text);
   });
   connect(this, &QLineEdit::editingFinished, [this]() {
-    QColor color = color_widgets::colorFromString(text(), p->show_alpha);
+    QColor color = p->colorFromText(text());
     if (color.isValid())
     {
       p->color = color;
@@ -193,6 +374,75 @@ void ColorLineEdit::setPreviewColor(bool previewColor)
   }
 }
 
+bool ColorLineEdit::completeNames() const
+{
+  return p->complete_names;
+}
+
+void ColorLineEdit::setCompleteNames(bool completeNames)
+{
+  if (completeNames == p->complete_names)
+    return;
+
+  p->complete_names = completeNames;
+  if (completeNames)
+  {
+    if (!p->completer)
+    {
+      p->names = new ColorNameModel(this);
+      p->completer = new QCompleter(p->names, this);
+      p->completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+      p->completer->setCaseSensitivity(Qt::CaseInsensitive);
+      connect(
+          p->completer,
+          (void (QCompleter::*)(const QModelIndex&)) & QCompleter::activated,
+          this,
+          [this](const QModelIndex& index) {
+            QColor color = index.data(Qt::DecorationRole).value<QColor>();
+            if (color.isValid())
+            {
+              p->color = color;
+              p->setPalette(color, this);
+              colorEdited(color);
+              colorChanged(color);
+            }
+          });
+    }
+    setCompleter(p->completer);
+  }
+  else
+  {
+    setCompleter(nullptr);
+  }
+  completeNamesChanged(completeNames);
+}
+
+ColorPaletteModel* ColorLineEdit::paletteModel() const
+{
+  return p->palette_model;
+}
+
+void ColorLineEdit::setPaletteModel(ColorPaletteModel* paletteModel)
+{
+  if (paletteModel == p->palette_model)
+    return;
+
+  if (p->palette_model)
+    disconnect(p->palette_model, nullptr, this, nullptr);
+
+  p->palette_model = paletteModel;
+  p->names_dirty = true;
+
+  if (paletteModel)
+  {
+    auto invalidate = [this] { p->names_dirty = true; };
+    connect(paletteModel, &QAbstractItemModel::modelReset, this, invalidate);
+    connect(paletteModel, &QAbstractItemModel::rowsInserted, this, invalidate);
+    connect(paletteModel, &QAbstractItemModel::rowsRemoved, this, invalidate);
+    connect(paletteModel, &QAbstractItemModel::dataChanged, this, invalidate);
+  }
+}
+
 void ColorLineEdit::paintEvent(QPaintEvent* event)
 {
   if (p->customAlpha())
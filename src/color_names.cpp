@@ -21,8 +21,12 @@
  */
 #include "color_names.hpp"
 
+#include "named_colors.hpp"
+
 #include <QRegularExpression>
 
+#include <cmath>
+
 static QRegularExpression
     regex_qcolor("^(?:(?:#[[:xdigit:]]{3})|(?:#[[:xdigit:]]{6})|(?:[[:alpha:]]+))$");
 static QRegularExpression
@@ -31,11 +35,62 @@ static QRegularExpression regex_hex_rgba("^#[[:xdigit:]]{8}$");
 static QRegularExpression regex_func_rgba(
     R"(^rgba?\s*\(\s*([0-9]+)\s*,\s*([0-9]+)\s*,\s*([0-9]+)\s*,\s*([0-9]+)\s*\)$)");
 
+/**
+ * \brief Index in named_colors of the given name, or -1
+ */
+static int named_color_index(const QString& name)
+{
+  using namespace color_widgets::detail;
+  if (name.size() > named_color_max_length)
+    return -1;
+
+  char latin1[named_color_max_length];
+  for (int i = 0; i < name.size(); i++)
+  {
+    QChar ch = name[i];
+    if (ch.unicode() > 0x7f)
+      return -1;
+    latin1[i] = ch.toLower().toLatin1();
+  }
+  return find_named_color(latin1, name.size());
+}
+
 namespace color_widgets
 {
 
-QString stringFromColor(const QColor& color, bool alpha)
+QString colorName(const QColor& color)
 {
+  if (!color.isValid() || color.alpha() != 255)
+    return QString();
+
+  int distance = 0;
+  int index = detail::nearest_named_color(color.rgb() & 0xffffff, &distance);
+  if (distance != 0)
+    return QString();
+  return QString::fromLatin1(detail::named_colors[index].name);
+}
+
+QString nearestColorName(const QColor& color, int* distance)
+{
+  if (!color.isValid())
+    return QString();
+
+  int squared = 0;
+  int index = detail::nearest_named_color(color.rgb() & 0xffffff, &squared);
+  if (distance)
+    *distance = qRound(std::sqrt(float(squared)));
+  return QString::fromLatin1(detail::named_colors[index].name);
+}
+
+QString stringFromColor(const QColor& color, bool alpha, bool names)
+{
+  if (names)
+  {
+    QString name = colorName(color);
+    if (!name.isEmpty())
+      return name;
+  }
+
   if (!alpha || color.alpha() == 255)
     return color.name();
   return color.name() + QString("%1").arg(color.alpha(), 2, 16, QChar('0'));
@@ -49,6 +104,12 @@ QColor colorFromString(const QString& string, bool alpha)
   match = regex_qcolor.match(xs);
   if (match.hasMatch())
   {
+    if (xs[0] != '#')
+    {
+      int index = named_color_index(xs);
+      if (index != -1)
+        return QColor(QRgb(detail::named_colors[index].rgb));
+    }
     return QColor(xs);
   }
 
@@ -21,13 +21,20 @@
  */
 #include "color_palette.hpp"
 
+#include "color_utils.hpp"
+#include "palette_source.hpp"
+
 #include <QFile>
 #include <QFileInfo>
 #include <QHash>
+#include <QImageReader>
 #include <QPainter>
 #include <QTextStream>
 
+#include <algorithm>
+#include <climits>
 #include <cmath>
+#include <memory>
 #include <wobjectimpl.h>
 W_OBJECT_IMPL(color_widgets::ColorPalette)
 namespace color_widgets
@@ -41,9 +48,386 @@ public:
   QString name;
   QString fileName;
   bool dirty{true};
+  /// Static colors used in place of \c colors until the palette is modified
+  const BuiltinPalette* builtin{nullptr};
+  /// Generated colors used in place of \c colors until the palette is modified
+  std::shared_ptr<const PaletteSource> source;
+
+  /// Whether the colors are read from \c builtin or \c source
+  bool external() const { return builtin || source; }
 
-  bool valid_index(int index) { return index >= 0 && index < colors.size(); }
+  int size() const
+  {
+    if (builtin)
+      return builtin->count;
+    if (source)
+      return source->count();
+    return colors.size();
+  }
+
+  bool valid_index(int index) { return index >= 0 && index < size(); }
+
+  QColor color(int index) const
+  {
+    if (builtin)
+      return QColor(QRgb(builtin->colors[index].rgb));
+    if (source)
+      return QColor::fromRgba(source->rgbAt(index));
+    return colors[index].first;
+  }
+
+  QString color_name(int index) const
+  {
+    if (builtin)
+      return QString::fromUtf8(builtin->colors[index].name);
+    if (source)
+      return QString();
+    return colors[index].second;
+  }
+
+  /**
+   * \brief Switches to \c colors, dropping the built-in or generated ones
+   */
+  void release_external()
+  {
+    builtin = nullptr;
+    source.reset();
+  }
+
+  /**
+   * \brief Copies the built-in or generated colors into \c colors so they
+   * can be modified
+   */
+  void materialize()
+  {
+    if (!external())
+      return;
+
+    colors.clear();
+    colors.reserve(size());
+    for (int i = 0, count = size(); i < count; i++)
+      colors.push_back(qMakePair(color(i), color_name(i)));
+    release_external();
+  }
+
+  /**
+   * \brief Folds \p from into \p into, keeping the first non-empty name
+   */
+  static void merge_into(QPair<QColor, QString>& into, const QPair<QColor, QString>& from)
+  {
+    if (into.second.isEmpty())
+      into.second = from.second;
+  }
+};
+
+namespace
+{
+/// Precomputed sort key and original position of a color
+struct SortItem
+{
+  quint16 key;
+  int index;
 };
+} // namespace
+
+/**
+ * \brief Packs the sort criteria for \p rgb into a 16 bit integer
+ */
+static quint16 sort_key(QRgb rgb, ColorPalette::SortKey key)
+{
+  int r = qRed(rgb), g = qGreen(rgb), b = qBlue(rgb);
+  int max = qMax(r, qMax(g, b));
+  int chroma = max - qMin(r, qMin(g, b));
+  int sat = max ? chroma * 255 / max : 0;
+
+  switch (key)
+  {
+    case ColorPalette::SortHue:
+    {
+      // 0 is for grays, actual hues are in [1, 360]
+      int hue = 0;
+      if (chroma)
+      {
+        int sextant;
+        if (max == r)
+          sextant = g - b + (g < b ? 6 * chroma : 0);
+        else if (max == g)
+          sextant = b - r + 2 * chroma;
+        else
+          sextant = r - g + 4 * chroma;
+        hue = 1 + sextant * 360 / (6 * chroma);
+      }
+      return quint16(hue << 7 | max >> 1);
+    }
+    case ColorPalette::SortSaturation:
+      return quint16(sat << 8 | max);
+    case ColorPalette::SortValue:
+      return quint16(max << 8 | sat);
+    case ColorPalette::SortLuma:
+      // Same weights as detail::color_lumaF, in 16 bit fixed point
+      return quint16((19661 * r + 38666 * g + 7209 * b) >> 8);
+    case ColorPalette::SortLightness:
+      return quint16(qBound(0, qRound(detail::color_to_oklab(rgb).l * 65535), 65535));
+    case ColorPalette::SortSmooth:
+      break;
+  }
+  return 0;
+}
+
+/**
+ * \brief Stable LSD radix sort on the 16 bit keys
+ */
+static void radix_sort(QVector<SortItem>& items)
+{
+  QVector<SortItem> buffer(items.size());
+  for (int shift = 0; shift < 16; shift += 8)
+  {
+    int offsets[257] = {};
+    for (const SortItem& item : items)
+      offsets[((item.key >> shift) & 0xff) + 1]++;
+    for (int i = 0; i < 256; i++)
+      offsets[i + 1] += offsets[i];
+    for (const SortItem& item : items)
+      buffer[offsets[(item.key >> shift) & 0xff]++] = item;
+    items.swap(buffer);
+  }
+}
+
+static const int smooth_cell_bits = 5;
+static const int smooth_cell_size = 1 << smooth_cell_bits;
+static const int smooth_cells = 256 >> smooth_cell_bits;
+
+static int smooth_cell(int r, int g, int b)
+{
+  return (r * smooth_cells + g) * smooth_cells + b;
+}
+
+/**
+ * \brief Greedy nearest neighbour chain starting from the darkest color
+ *
+ * Colors not yet in the chain are bucketed in a coarse RGB grid, so each step
+ * only looks at the cells surrounding the last color instead of all of them.
+ */
+static QVector<int> smooth_order(const QVector<QRgb>& colors)
+{
+  QVector<QVector<int>> grid(smooth_cells * smooth_cells * smooth_cells);
+  QVector<int> slot(colors.size());
+  int current = 0;
+  int current_luma = INT_MAX;
+  for (int i = 0; i < colors.size(); i++)
+  {
+    QRgb c = colors[i];
+    QVector<int>& cell = grid[smooth_cell(
+        qRed(c) >> smooth_cell_bits, qGreen(c) >> smooth_cell_bits, qBlue(c) >> smooth_cell_bits)];
+    slot[i] = cell.size();
+    cell.push_back(i);
+    int luma = sort_key(c, ColorPalette::SortLuma);
+    if (luma < current_luma)
+    {
+      current = i;
+      current_luma = luma;
+    }
+  }
+
+  auto take = [&](int index) {
+    QRgb c = colors[index];
+    QVector<int>& cell = grid[smooth_cell(
+        qRed(c) >> smooth_cell_bits, qGreen(c) >> smooth_cell_bits, qBlue(c) >> smooth_cell_bits)];
+    int last = cell.back();
+    cell[slot[index]] = last;
+    slot[last] = slot[index];
+    cell.pop_back();
+  };
+
+  QVector<int> order;
+  order.reserve(colors.size());
+  take(current);
+  order.push_back(current);
+
+  while (order.size() < colors.size())
+  {
+    QRgb c = colors[current];
+    int r = qRed(c), g = qGreen(c), b = qBlue(c);
+    int cr = r >> smooth_cell_bits, cg = g >> smooth_cell_bits, cb = b >> smooth_cell_bits;
+    int best = -1;
+    int best_dist = INT_MAX;
+
+    for (int ring = 0; ring < smooth_cells; ring++)
+    {
+      // Colors in this ring are at least this far away
+      int reach = qMax(0, ring - 1) * smooth_cell_size;
+      if (best != -1 && reach * reach >= best_dist)
+        break;
+
+      for (int x = qMax(0, cr - ring); x <= qMin(smooth_cells - 1, cr + ring); x++)
+      {
+        for (int y = qMax(0, cg - ring); y <= qMin(smooth_cells - 1, cg + ring); y++)
+        {
+          for (int z = qMax(0, cb - ring); z <= qMin(smooth_cells - 1, cb + ring); z++)
+          {
+            if (qMax(qAbs(x - cr), qMax(qAbs(y - cg), qAbs(z - cb))) != ring)
+              continue;
+            for (int index : grid[smooth_cell(x, y, z)])
+            {
+              QRgb other = colors[index];
+              int dr = qRed(other) - r, dg = qGreen(other) - g, db = qBlue(other) - b;
+              int dist = dr * dr + dg * dg + db * db;
+              if (dist < best_dist || (dist == best_dist && index < best))
+              {
+                best = index;
+                best_dist = dist;
+              }
+            }
+          }
+        }
+      }
+    }
+
+    take(best);
+    order.push_back(best);
+    current = best;
+  }
+
+  return order;
+}
+
+namespace
+{
+/// Bin of the 15 bit histogram used by loadImageColors()
+struct HistogramBin
+{
+  qint64 count;
+  qint64 sum[3]; ///< Sum of each channel, to get the average color of the bin
+};
+
+/// Box of histogram bins for the median cut, bins[begin] to bins[end]
+struct CutBox
+{
+  int begin;
+  int end;
+  qint64 count;
+  int axis;   ///< Channel with the largest range
+  int extent; ///< Range of the colors along axis
+};
+} // namespace
+
+/// Maximum number of pixels loaded at once by loadImageColors()
+static const qint64 extraction_budget = 1 << 24;
+
+static void accumulate_histogram(const QImage& image, QVector<HistogramBin>& histogram)
+{
+  QImage argb = image.convertToFormat(QImage::Format_ARGB32);
+  for (int y = 0; y < argb.height(); y++)
+  {
+    auto line = reinterpret_cast<const QRgb*>(argb.constScanLine(y));
+    for (int x = 0; x < argb.width(); x++)
+    {
+      QRgb rgb = line[x];
+      if (qAlpha(rgb) == 0)
+        continue;
+      int r = qRed(rgb), g = qGreen(rgb), b = qBlue(rgb);
+      HistogramBin& bin = histogram[(r >> 3) << 10 | (g >> 3) << 5 | (b >> 3)];
+      bin.count++;
+      bin.sum[0] += r;
+      bin.sum[1] += g;
+      bin.sum[2] += b;
+    }
+  }
+}
+
+static int bin_channel(const HistogramBin& bin, int channel)
+{
+  return int(bin.sum[channel] / bin.count);
+}
+
+static CutBox cut_box(const QVector<HistogramBin>& bins, int begin, int end)
+{
+  CutBox box{begin, end, 0, 0, 0};
+  int min[3] = {255, 255, 255};
+  int max[3] = {0, 0, 0};
+  for (int i = begin; i < end; i++)
+  {
+    box.count += bins[i].count;
+    for (int c = 0; c < 3; c++)
+    {
+      int value = bin_channel(bins[i], c);
+      min[c] = qMin(min[c], value);
+      max[c] = qMax(max[c], value);
+    }
+  }
+  for (int c = 0; c < 3; c++)
+  {
+    if (max[c] - min[c] > box.extent)
+    {
+      box.extent = max[c] - min[c];
+      box.axis = c;
+    }
+  }
+  return box;
+}
+
+/**
+ * \brief Reduces the non-empty histogram bins to at most \p max_colors boxes
+ * with the median cut algorithm
+ * \returns The average color of each box, most frequent first
+ */
+static QVector<QPair<QColor, QString>> median_cut(QVector<HistogramBin> bins, int max_colors)
+{
+  QVector<CutBox> boxes;
+  boxes.push_back(cut_box(bins, 0, bins.size()));
+
+  while (boxes.size() < max_colors)
+  {
+    // Split the box with the most pixels spread over the widest range
+    int split = -1;
+    qint64 best = 0;
+    for (int i = 0; i < boxes.size(); i++)
+    {
+      qint64 score = boxes[i].count * boxes[i].extent;
+      if (boxes[i].end - boxes[i].begin > 1 && score > best)
+      {
+        split = i;
+        best = score;
+      }
+    }
+    if (split == -1)
+      break;
+
+    CutBox box = boxes[split];
+    std::sort(
+        bins.begin() + box.begin,
+        bins.begin() + box.end,
+        [axis = box.axis](const HistogramBin& a, const HistogramBin& b) {
+          return bin_channel(a, axis) < bin_channel(b, axis);
+        });
+
+    int middle = box.begin + 1;
+    qint64 count = bins[box.begin].count;
+    while (middle < box.end - 1 && count * 2 < box.count)
+      count += bins[middle++].count;
+
+    boxes[split] = cut_box(bins, box.begin, middle);
+    boxes.push_back(cut_box(bins, middle, box.end));
+  }
+
+  std::sort(boxes.begin(), boxes.end(), [](const CutBox& a, const CutBox& b) {
+    return a.count > b.count;
+  });
+
+  QVector<QPair<QColor, QString>> colors;
+  colors.reserve(boxes.size());
+  for (const CutBox& box : boxes)
+  {
+    qint64 sum[3] = {0, 0, 0};
+    for (int i = box.begin; i < box.end; i++)
+      for (int c = 0; c < 3; c++)
+        sum[c] += bins[i].sum[c];
+    colors.push_back(qMakePair(
+        QColor(int(sum[0] / box.count), int(sum[1] / box.count), int(sum[2] / box.count)),
+        QString()));
+  }
+  return colors;
+}
 
 ColorPalette::ColorPalette(const QString& name) : p(new Private)
 {
@@ -63,6 +447,23 @@ ColorPalette::ColorPalette(
   p->dirty = false;
 }
 
+ColorPalette::ColorPalette(const BuiltinPalette& palette) : p(new Private)
+{
+  p->builtin = &palette;
+  p->name = QString::fromUtf8(palette.name);
+  p->columns = palette.columns;
+  p->dirty = false;
+}
+
+ColorPalette::ColorPalette(const PaletteSource& source, const QString& name, int columns)
+    : p(new Private)
+{
+  p->source = std::make_shared<const PaletteSource>(source);
+  p->name = name;
+  p->columns = qMax(0, columns);
+  p->dirty = false;
+}
+
 ColorPalette::ColorPalette(const ColorPalette& other) : QObject(), p(new Private(*other.p)) { }
 
 ColorPalette& ColorPalette::operator=(const ColorPalette& other)
@@ -90,7 +491,7 @@ ColorPalette& ColorPalette::operator=(ColorPalette&& other)
 
 void ColorPalette::emitUpdate()
 {
-  colorsChanged(p->colors);
+  colorsChanged(colors());
   columnsChanged(p->columns);
   nameChanged(p->name);
   fileNameChanged(p->fileName);
@@ -99,22 +500,29 @@ void ColorPalette::emitUpdate()
 
 QColor ColorPalette::colorAt(int index) const
 {
-  return p->valid_index(index) ? p->colors[index].first : QColor();
+  return p->valid_index(index) ? p->color(index) : QColor();
 }
 
 QString ColorPalette::nameAt(int index) const
 {
-  return p->valid_index(index) ? p->colors[index].second : QString();
+  return p->valid_index(index) ? p->color_name(index) : QString();
 }
 
 QVector<QPair<QColor, QString>> ColorPalette::colors() const
 {
-  return p->colors;
+  if (!p->external())
+    return p->colors;
+
+  QVector<QPair<QColor, QString>> out;
+  out.reserve(p->size());
+  for (int i = 0; i < p->size(); i++)
+    out.push_back(qMakePair(p->color(i), p->color_name(i)));
+  return out;
 }
 
 int ColorPalette::count() const
 {
-  return p->colors.size();
+  return p->size();
 }
 
 int ColorPalette::columns()
@@ -129,6 +537,7 @@ QString ColorPalette::name() const
 
 void ColorPalette::loadColorTable(const QVector<QRgb>& color_table)
 {
+  p->release_external();
   p->colors.clear();
   p->colors.reserve(color_table.size());
   for (QRgb c : color_table)
@@ -147,6 +556,7 @@ bool ColorPalette::loadImage(const QImage& image)
     return false;
   setColumns(image.width());
 
+  p->release_external();
   p->colors.clear();
   p->colors.reserve(image.width() * image.height());
   for (int y = 0; y < image.height(); y++)
@@ -163,6 +573,74 @@ bool ColorPalette::loadImage(const QImage& image)
   return true;
 }
 
+bool ColorPalette::loadImageColors(
+    const QString& file_name, int max_colors, const Progress& progress)
+{
+  if (max_colors <= 0)
+    return false;
+
+  QImageReader reader(file_name);
+  QSize size = reader.size();
+  qint64 total = size.isValid() ? qint64(size.width()) * size.height() : 0;
+  auto report = [&progress, &total](qint64 done) { return !progress || progress(done, total); };
+  if (!report(0))
+    return false;
+
+  QVector<HistogramBin> histogram(1 << 15);
+  if (total > extraction_budget && reader.supportsOption(QImageIOHandler::ClipRect))
+  {
+    // Tiles of at most extraction_budget pixels, each with its own reader
+    // as a handler reads the image only once
+    int tile_width = int(qMin<qint64>(size.width(), extraction_budget));
+    int tile_height = int(qMin<qint64>(size.height(), extraction_budget / tile_width));
+    QRect bounds(QPoint(0, 0), size);
+    qint64 done = 0;
+    for (int y = 0; y < size.height(); y += tile_height)
+    {
+      for (int x = 0; x < size.width(); x += tile_width)
+      {
+        QRect tile = QRect(x, y, tile_width, tile_height) & bounds;
+        QImageReader tile_reader(file_name, reader.format());
+        tile_reader.setClipRect(tile);
+        QImage image = tile_reader.read();
+        if (image.isNull())
+          return false;
+        accumulate_histogram(image, histogram);
+        done += qint64(tile.width()) * tile.height();
+        if (!report(done))
+          return false;
+      }
+    }
+  }
+  else
+  {
+    // Without native clipping each tile would decode the whole image, so
+    // large images are decoded at a reduced size with about the same colors
+    if (total > extraction_budget)
+      reader.setScaledSize(size * std::sqrt(double(extraction_budget) / total));
+    QImage image = reader.read();
+    if (image.isNull())
+      return false;
+    accumulate_histogram(image, histogram);
+    image = QImage();
+    if (!report(total))
+      return false;
+  }
+
+  QVector<HistogramBin> bins;
+  for (const HistogramBin& bin : histogram)
+    if (bin.count)
+      bins.push_back(bin);
+  histogram.clear();
+
+  p->release_external();
+  p->colors = bins.empty() ? QVector<QPair<QColor, QString>>() : median_cut(bins, max_colors);
+  setColumns(0);
+  colorsChanged(p->colors);
+  setDirty(true);
+  return true;
+}
+
 ColorPalette ColorPalette::fromImage(const QImage& image)
 {
   ColorPalette p;
@@ -173,6 +651,7 @@ ColorPalette ColorPalette::fromImage(const QImage& image)
 bool ColorPalette::load(const QString& name)
 {
   p->fileName = name;
+  p->release_external();
   p->colors.clear();
   p->columns = 0;
   p->dirty = false;
@@ -275,12 +754,12 @@ bool ColorPalette::save()
   /// \todo Options to add comments
   stream << "#\n";
 
-  for (int i = 0; i < p->colors.size(); i++)
+  for (int i = 0; i < p->size(); i++)
   {
-    stream << qSetFieldWidth(3) << p->colors[i].first.red() << qSetFieldWidth(0) << ' '
-           << qSetFieldWidth(3) << p->colors[i].first.green() << qSetFieldWidth(0) << ' '
-           << qSetFieldWidth(3) << p->colors[i].first.blue() << qSetFieldWidth(0) << '\t'
-           << unnamed(p->colors[i].second) << '\n';
+    QColor color = p->color(i);
+    stream << qSetFieldWidth(3) << color.red() << qSetFieldWidth(0) << ' ' << qSetFieldWidth(3)
+           << color.green() << qSetFieldWidth(0) << ' ' << qSetFieldWidth(3) << color.blue()
+           << qSetFieldWidth(0) << '\t' << unnamed(p->color_name(i)) << '\n';
   }
 
   if (!file.error())
@@ -311,6 +790,7 @@ void ColorPalette::setColumns(int columns)
 
 void ColorPalette::setColors(const QVector<QPair<QColor, QString>>& colors)
 {
+  p->release_external();
   p->colors = colors;
   setDirty(true);
   colorsChanged(p->colors);
@@ -321,6 +801,7 @@ void ColorPalette::setColorAt(int index, const QColor& color)
   if (!p->valid_index(index))
     return;
 
+  p->materialize();
   p->colors[index].first = color;
 
   setDirty(true);
@@ -333,6 +814,7 @@ void ColorPalette::setColorAt(int index, const QColor& color, const QString& nam
   if (!p->valid_index(index))
     return;
 
+  p->materialize();
   p->colors[index].first = color;
   p->colors[index].second = name;
   setDirty(true);
@@ -345,6 +827,7 @@ void ColorPalette::setNameAt(int index, const QString& name)
   if (!p->valid_index(index))
     return;
 
+  p->materialize();
   p->colors[index].second = name;
 
   setDirty(true);
@@ -354,6 +837,7 @@ void ColorPalette::setNameAt(int index, const QString& name)
 
 void ColorPalette::appendColor(const QColor& color, const QString& name)
 {
+  p->materialize();
   p->colors.push_back(qMakePair(color, name));
   setDirty(true);
   colorAdded(p->colors.size() - 1);
@@ -362,9 +846,10 @@ void ColorPalette::appendColor(const QColor& color, const QString& name)
 
 void ColorPalette::insertColor(int index, const QColor& color, const QString& name)
 {
-  if (index < 0 || index > p->colors.size())
+  if (index < 0 || index > p->size())
     return;
 
+  p->materialize();
   p->colors.insert(index, qMakePair(color, name));
 
   setDirty(true);
@@ -377,6 +862,7 @@ void ColorPalette::eraseColor(int index)
   if (!p->valid_index(index))
     return;
 
+  p->materialize();
   p->colors.remove(index);
 
   setDirty(true);
@@ -384,6 +870,150 @@ void ColorPalette::eraseColor(int index)
   colorsUpdated(p->colors);
 }
 
+void ColorPalette::sortBy(SortKey key)
+{
+  if (p->size() < 2)
+    return;
+
+  p->materialize();
+
+  QVector<int> order;
+  if (key == SortSmooth)
+  {
+    order = smooth_order(colorTable());
+  }
+  else
+  {
+    QVector<SortItem> items;
+    items.reserve(p->colors.size());
+    for (int i = 0; i < p->colors.size(); i++)
+      items.push_back({sort_key(p->colors[i].first.rgb(), key), i});
+    radix_sort(items);
+
+    order.reserve(items.size());
+    for (const SortItem& item : items)
+      order.push_back(item.index);
+  }
+
+  QVector<QPair<QColor, QString>> sorted;
+  sorted.reserve(p->colors.size());
+  for (int index : order)
+    sorted.push_back(std::move(p->colors[index]));
+  p->colors = std::move(sorted);
+
+  setDirty(true);
+  colorsChanged(p->colors);
+}
+
+int ColorPalette::removeDuplicates()
+{
+  p->materialize();
+  QHash<QRgb, int> kept;
+  kept.reserve(p->colors.size());
+  QVector<QPair<QColor, QString>> unique;
+  unique.reserve(p->colors.size());
+
+  for (const auto& color : p->colors)
+  {
+    QRgb rgba = color.first.rgba();
+    auto it = kept.constFind(rgba);
+    if (it == kept.constEnd())
+    {
+      kept.insert(rgba, unique.size());
+      unique.push_back(color);
+    }
+    else
+    {
+      Private::merge_into(unique[*it], color);
+    }
+  }
+
+  int removed = p->colors.size() - unique.size();
+  if (removed)
+  {
+    p->colors = std::move(unique);
+    setDirty(true);
+    colorsChanged(p->colors);
+  }
+  return removed;
+}
+
+int ColorPalette::mergeSimilar(int tolerance)
+{
+  if (tolerance <= 0)
+    return removeDuplicates();
+
+  // Uniform grid with cells as wide as the tolerance: any color within
+  // range of a kept one lies in the same cell or in one of its neighbours
+  auto cell_key = [tolerance](int r, int g, int b, int a) {
+    return quint64(r / tolerance) << 48 | quint64(g / tolerance) << 32
+           | quint64(b / tolerance) << 16 | quint64(a / tolerance);
+  };
+  const int max_dist = tolerance * tolerance;
+
+  p->materialize();
+  QHash<quint64, QVector<int>> grid;
+  QVector<QPair<QColor, QString>> merged;
+  merged.reserve(p->colors.size());
+
+  for (const auto& color : p->colors)
+  {
+    QRgb rgba = color.first.rgba();
+    int r = qRed(rgba), g = qGreen(rgba), b = qBlue(rgba), a = qAlpha(rgba);
+    int best = -1;
+    int best_dist = max_dist + 1;
+
+    for (int dr = -tolerance; dr <= tolerance; dr += tolerance)
+    {
+      for (int dg = -tolerance; dg <= tolerance; dg += tolerance)
+      {
+        for (int db = -tolerance; db <= tolerance; db += tolerance)
+        {
+          for (int da = -tolerance; da <= tolerance; da += tolerance)
+          {
+            if (r + dr < 0 || g + dg < 0 || b + db < 0 || a + da < 0)
+              continue;
+            auto cell = grid.constFind(cell_key(r + dr, g + dg, b + db, a + da));
+            if (cell == grid.constEnd())
+              continue;
+            for (int index : *cell)
+            {
+              QRgb other = merged[index].first.rgba();
+              int xr = qRed(other) - r, xg = qGreen(other) - g;
+              int xb = qBlue(other) - b, xa = qAlpha(other) - a;
+              int dist = xr * xr + xg * xg + xb * xb + xa * xa;
+              if (dist < best_dist || (dist == best_dist && index < best))
+              {
+                best = index;
+                best_dist = dist;
+              }
+            }
+          }
+        }
+      }
+    }
+
+    if (best == -1)
+    {
+      grid[cell_key(r, g, b, a)].push_back(merged.size());
+      merged.push_back(color);
+    }
+    else
+    {
+      Private::merge_into(merged[best], color);
+    }
+  }
+
+  int removed = p->colors.size() - merged.size();
+  if (removed)
+  {
+    p->colors = std::move(merged);
+    setDirty(true);
+    colorsChanged(p->colors);
+  }
+  return removed;
+}
+
 void ColorPalette::setName(const QString& name)
 {
   setDirty(true);
@@ -403,14 +1033,14 @@ QString ColorPalette::unnamed(const QString& name) const
 
 QPixmap ColorPalette::preview(const QSize& size, const QColor& background) const
 {
-  if (!size.isValid() || p->colors.empty())
+  if (!size.isValid() || p->size() == 0)
     return QPixmap();
 
   QPixmap out(size);
   out.fill(background);
   QPainter painter(&out);
 
-  int count = p->colors.size();
+  int count = p->size();
   int columns = p->columns;
   if (!columns)
     columns = std::ceil(std::sqrt(count * float(size.width()) / size.height()));
@@ -427,7 +1057,7 @@ QPixmap ColorPalette::preview(const QSize& size, const QColor& background) const
               y * color_size.height(),
               color_size.width(),
               color_size.height()),
-          p->colors[i].first);
+          p->color(i));
     }
   }
 
@@ -448,18 +1078,18 @@ void ColorPalette::setDirty(bool dirty)
 QVector<QColor> ColorPalette::onlyColors() const
 {
   QVector<QColor> out;
-  out.reserve(p->colors.size());
-  for (int i = 0; i < p->colors.size(); i++)
-    out.push_back(p->colors[i].first);
+  out.reserve(p->size());
+  for (int i = 0; i < p->size(); i++)
+    out.push_back(p->color(i));
   return out;
 }
 
 QVector<QRgb> ColorPalette::colorTable() const
 {
   QVector<QRgb> out;
-  out.reserve(p->colors.size());
-  for (const auto& color_pair : p->colors)
-    out.push_back(color_pair.first.rgba());
+  out.reserve(p->size());
+  for (int i = 0; i < p->size(); i++)
+    out.push_back(p->color(i).rgba());
   return out;
 }
 
@@ -21,10 +21,17 @@
  */
 #include "color_palette_model.hpp"
 
+#include "color_utils.hpp"
+
 #include <QDir>
+#include <QHash>
 #include <QList>
 #include <QRegularExpression>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+
 #include <wobjectimpl.h>
 W_OBJECT_IMPL(color_widgets::ColorPaletteModel)
 namespace color_widgets
@@ -33,17 +40,278 @@ namespace color_widgets
 class ColorPaletteModel::Private
 {
 public:
+  /// Color stored in the search index
+  struct IndexEntry
+  {
+    int palette;
+    int index;
+    QRgb rgb;
+  };
+
+  /// Number of bits per channel used to quantize the index cells
+  static const int index_bits = 4;
+
+  /// Bins per OKLab axis in the palette signatures
+  static const int signature_bins = 4;
+
+  /// Normalized histogram of the palette colors in OKLab
+  using Signature = std::array<float, signature_bins * signature_bins * signature_bins>;
+
+  /// Name stored in the trigram index
+  struct NameEntry
+  {
+    int palette;
+    int index; ///< -1 for the palette name
+    QString folded;
+    int trigrams; ///< Number of distinct padded trigrams in folded
+  };
+
+  /// Minimum similarity for approximate name matches
+  static constexpr float fuzzy_threshold = 0.5f;
+
   /// \todo Keep sorted by name (?)
   QList<ColorPalette> palettes;
+  /// Static palettes restored by load()
+  QVector<const BuiltinPalette*> builtins;
   QSize icon_size;
   QStringList search_paths;
   QString save_path;
+  /// Quantized color -> colors of all the palettes falling in that cell
+  QHash<quint16, QVector<IndexEntry>> color_index;
+  /// Signatures of the palettes, in the same order as palettes
+  QVector<Signature> signatures;
+  /// Palette and color names, lazily rebuilt when palettes are modified
+  mutable QVector<NameEntry> names;
+  /// Trigram -> indices in names
+  mutable QHash<quint64, QVector<int>> name_trigrams;
+  mutable bool names_dirty = true;
+  /// Case folded text of the last findNames() query
+  mutable QString last_query;
+  /// Indices in names containing last_query
+  mutable QVector<int> last_substring_matches;
 
   Private() : icon_size(32, 32) { }
 
+  static quint16 index_cell(int r, int g, int b)
+  {
+    return quint16(r << (2 * index_bits) | g << index_bits | b);
+  }
+
+  static quint16 index_cell(QRgb rgb)
+  {
+    return index_cell(
+        qRed(rgb) >> (8 - index_bits),
+        qGreen(rgb) >> (8 - index_bits),
+        qBlue(rgb) >> (8 - index_bits));
+  }
+
+  void index_palette(int palette)
+  {
+    const ColorPalette& pal = palettes[palette];
+    for (int i = 0; i < pal.count(); i++)
+    {
+      QRgb rgb = pal.colorAt(i).rgb();
+      color_index[index_cell(rgb)].push_back({palette, i, rgb});
+    }
+  }
+
+  /**
+   * \brief Removes the entries of \p palette from the index
+   * \param shift Whether the palette is being removed from the model, and the
+   *              indices of the following palettes need to be updated
+   */
+  void unindex_palette(int palette, bool shift)
+  {
+    for (auto it = color_index.begin(); it != color_index.end();)
+    {
+      QVector<IndexEntry>& entries = *it;
+      entries.erase(
+          std::remove_if(
+              entries.begin(),
+              entries.end(),
+              [palette](const IndexEntry& entry) { return entry.palette == palette; }),
+          entries.end());
+
+      if (shift)
+      {
+        for (IndexEntry& entry : entries)
+          if (entry.palette > palette)
+            entry.palette--;
+      }
+
+      if (entries.isEmpty())
+        it = color_index.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  /**
+   * \brief Computes the signature of a palette
+   *
+   * Each color is spread over the 8 closest bins (trilinear weights) so
+   * slightly different colors near a bin edge still produce close signatures.
+   */
+  static Signature signature(const ColorPalette& palette)
+  {
+    Signature sig;
+    sig.fill(0);
+    if (palette.count() == 0)
+      return sig;
+
+    const int n = signature_bins;
+    // OKLab a and b for sRGB colors are within about [-0.3, 0.3]
+    auto bin_coord = [n](float v, float min, float max) {
+      return qBound(0.f, (v - min) / (max - min) * (n - 1), float(n - 1));
+    };
+
+    for (int i = 0; i < palette.count(); i++)
+    {
+      detail::oklab lab = detail::color_to_oklab(palette.colorAt(i).rgb());
+      float coords[3] = {
+          bin_coord(lab.l, 0, 1),
+          bin_coord(lab.a, -0.3f, 0.3f),
+          bin_coord(lab.b, -0.3f, 0.3f),
+      };
+      int base[3];
+      float frac[3];
+      for (int c = 0; c < 3; c++)
+      {
+        base[c] = qMin(int(coords[c]), n - 2);
+        frac[c] = coords[c] - base[c];
+      }
+
+      for (int corner = 0; corner < 8; corner++)
+      {
+        float weight = 1;
+        int bin = 0;
+        for (int c = 0; c < 3; c++)
+        {
+          int offset = (corner >> c) & 1;
+          weight *= offset ? frac[c] : 1 - frac[c];
+          bin = bin * n + base[c] + offset;
+        }
+        sig[bin] += weight;
+      }
+    }
+
+    for (float& bin : sig)
+      bin /= palette.count();
+    return sig;
+  }
+
+  /// L1 distance between signatures, in [0, 2]
+  static float signature_distance(const Signature& a, const Signature& b)
+  {
+    float distance = 0;
+    for (int i = 0; i < int(a.size()); i++)
+      distance += qAbs(a[i] - b[i]);
+    return distance;
+  }
+
+  static quint64 trigram(const QChar* chars)
+  {
+    return quint64(chars[0].unicode()) << 32 | quint64(chars[1].unicode()) << 16
+           | chars[2].unicode();
+  }
+
+  /**
+   * \brief Distinct trigrams of \p folded
+   * \param padded Whether to include trigrams at the word boundaries, so
+   *               short strings have trigrams too
+   */
+  static QVector<quint64> trigrams(const QString& folded, bool padded)
+  {
+    QString text = padded ? "  " + folded + " " : folded;
+    QVector<quint64> out;
+    for (int i = 0; i + 3 <= text.size(); i++)
+      out.push_back(trigram(text.constData() + i));
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return out;
+  }
+
+  void index_name(int palette, int index, const QString& name) const
+  {
+    if (name.isEmpty())
+      return;
+    NameEntry entry{palette, index, name.toCaseFolded(), 0};
+    QVector<quint64> grams = trigrams(entry.folded, true);
+    entry.trigrams = grams.size();
+    for (quint64 gram : grams)
+      name_trigrams[gram].push_back(names.size());
+    names.push_back(entry);
+  }
+
+  void index_names(int palette) const
+  {
+    const ColorPalette& pal = palettes[palette];
+    index_name(palette, -1, pal.name());
+    for (int i = 0; i < pal.count(); i++)
+      index_name(palette, i, pal.nameAt(i));
+  }
+
+  void ensure_names() const
+  {
+    if (!names_dirty)
+      return;
+    names.clear();
+    name_trigrams.clear();
+    for (int i = 0; i < palettes.size(); i++)
+      index_names(i);
+    names_dirty = false;
+  }
+
+  /// Invalidates the name index, it will be rebuilt on the next search
+  void invalidate_names()
+  {
+    names_dirty = true;
+    last_query.clear();
+    last_substring_matches.clear();
+  }
+
+  /// Updates the cached data for a palette that has been appended or replaced
+  void cache_palette(int palette, bool replaced)
+  {
+    if (replaced)
+    {
+      unindex_palette(palette, false);
+      signatures[palette] = signature(palettes[palette]);
+    }
+    else
+    {
+      signatures.push_back(signature(palettes[palette]));
+    }
+    index_palette(palette);
+
+    last_query.clear();
+    if (replaced)
+      invalidate_names();
+    else if (!names_dirty)
+      index_names(palette);
+  }
+
+  /// Updates the cached data after a palette has been removed
+  void uncache_palette(int palette)
+  {
+    unindex_palette(palette, true);
+    signatures.remove(palette);
+    invalidate_names();
+  }
+
+  void rebuild_caches()
+  {
+    invalidate_names();
+    color_index.clear();
+    signatures.clear();
+    signatures.reserve(palettes.size());
+    for (int i = 0; i < palettes.size(); i++)
+      cache_palette(i, false);
+  }
+
   bool acceptable(const QModelIndex& index) const { return acceptable(index.row()); }
 
-  bool acceptable(int row) const { return row >= 0 && row <= palettes.count(); }
+  bool acceptable(int row) const { return row >= 0 && row < palettes.count(); }
 
   QList<ColorPalette>::iterator find(const QString& name)
   {
@@ -144,8 +412,11 @@ bool ColorPaletteModel::removeRows(int row, int count, const QModelIndex& parent
   if (!p->acceptable(row) || count <= 0)
     return false;
 
+  int last = qMin(row + count, p->palettes.size()) - 1;
+  beginRemoveRows(parent, row, last);
+
   auto begin = p->palettes.begin() + row;
-  auto end = row + count >= p->palettes.size() ? p->palettes.end() : begin + count;
+  auto end = p->palettes.begin() + last + 1;
   for (auto it = begin; it != end; ++it)
   {
     if (!it->fileName().isEmpty())
@@ -157,6 +428,8 @@ bool ColorPaletteModel::removeRows(int row, int count, const QModelIndex& parent
   }
 
   p->palettes.erase(begin, end);
+  p->rebuild_caches();
+  endRemoveRows();
 
   return true;
 }
@@ -209,6 +482,8 @@ void ColorPaletteModel::load()
 {
   beginResetModel();
   p->palettes.clear();
+  for (const BuiltinPalette* builtin : p->builtins)
+    p->palettes.push_back(ColorPalette(*builtin));
   QStringList filters;
   filters << "*.gpl";
   for (const QString& directory_name : p->search_paths)
@@ -226,9 +501,26 @@ void ColorPaletteModel::load()
       }
     }
   }
+  p->rebuild_caches();
   endResetModel();
 }
 
+void ColorPaletteModel::addBuiltinPalettes(const BuiltinPalette* palettes, int count)
+{
+  if (count <= 0)
+    return;
+
+  beginInsertRows(QModelIndex(), p->palettes.size(), p->palettes.size() + count - 1);
+  p->builtins.reserve(p->builtins.size() + count);
+  for (int i = 0; i < count; i++)
+  {
+    p->builtins.push_back(&palettes[i]);
+    p->palettes.push_back(ColorPalette(palettes[i]));
+    p->cache_palette(p->palettes.size() - 1, false);
+  }
+  endInsertRows();
+}
+
 bool ColorPaletteModel::hasPalette(const QString& name) const
 {
   return p->find(name) != p->palettes.end();
@@ -259,6 +551,9 @@ bool ColorPaletteModel::updatePalette(int index, const ColorPalette& palette, bo
   // Update the palette
   ColorPalette& local_palette = p->palettes[index] = palette;
   p->fixUnnamed(local_palette);
+  p->cache_palette(index, true);
+  QModelIndex changed = this->index(index);
+  dataChanged(changed, changed);
 
   if (save)
     return p->save(local_palette, filename);
@@ -275,6 +570,7 @@ bool ColorPaletteModel::removePalette(int index, bool remove_file)
 
   beginRemoveRows(QModelIndex(), index, index);
   p->palettes.removeAt(index);
+  p->uncache_palette(index);
   endRemoveRows();
 
   if (!file_name.isEmpty() && remove_file)
@@ -293,6 +589,7 @@ bool ColorPaletteModel::addPalette(const ColorPalette& palette, bool save)
   beginInsertRows(QModelIndex(), p->palettes.size(), p->palettes.size());
   p->palettes.push_back(palette);
   p->fixUnnamed(p->palettes.back());
+  p->cache_palette(p->palettes.size() - 1, false);
   endInsertRows();
 
   if (save)
@@ -314,4 +611,232 @@ int ColorPaletteModel::indexFromFile(const QString& filename) const
   return -1;
 }
 
+QVector<ColorPaletteModel::ColorMatch>
+    ColorPaletteModel::findColor(const QColor& color, int max_distance, int max_results) const
+{
+  QVector<ColorMatch> matches;
+  if (!color.isValid() || max_results == 0)
+    return matches;
+
+  max_distance = qMax(0, max_distance);
+  QRgb rgb = color.rgb();
+  int r = qRed(rgb), g = qGreen(rgb), b = qBlue(rgb);
+  const int shift = 8 - Private::index_bits;
+  const int max_dist = max_distance * max_distance;
+
+  // Visit only the cells overlapping the bounding box of the search sphere
+  auto first_cell = [=](int c) { return qMax(0, c - max_distance) >> shift; };
+  auto last_cell = [=](int c) { return qMin(255, c + max_distance) >> shift; };
+
+  for (int cr = first_cell(r); cr <= last_cell(r); cr++)
+  {
+    for (int cg = first_cell(g); cg <= last_cell(g); cg++)
+    {
+      for (int cb = first_cell(b); cb <= last_cell(b); cb++)
+      {
+        auto cell = p->color_index.constFind(Private::index_cell(cr, cg, cb));
+        if (cell == p->color_index.constEnd())
+          continue;
+
+        for (const Private::IndexEntry& entry : *cell)
+        {
+          int dr = qRed(entry.rgb) - r, dg = qGreen(entry.rgb) - g, db = qBlue(entry.rgb) - b;
+          int dist = dr * dr + dg * dg + db * db;
+          if (dist <= max_dist)
+            matches.push_back({entry.palette, entry.index, dist});
+        }
+      }
+    }
+  }
+
+  auto closer = [](const ColorMatch& a, const ColorMatch& b) {
+    if (a.distance != b.distance)
+      return a.distance < b.distance;
+    if (a.palette != b.palette)
+      return a.palette < b.palette;
+    return a.index < b.index;
+  };
+
+  if (max_results > 0 && max_results < matches.size())
+  {
+    std::partial_sort(matches.begin(), matches.begin() + max_results, matches.end(), closer);
+    matches.resize(max_results);
+  }
+  else
+  {
+    std::sort(matches.begin(), matches.end(), closer);
+  }
+
+  for (ColorMatch& match : matches)
+    match.distance = qRound(std::sqrt(qreal(match.distance)));
+
+  return matches;
+}
+
+/**
+ * \brief Sorts \p matches by distance, keeping at most \p max_results
+ */
+static void rank_palettes(QVector<ColorPaletteModel::PaletteMatch>& matches, int max_results)
+{
+  auto closer = [](const ColorPaletteModel::PaletteMatch& a,
+                   const ColorPaletteModel::PaletteMatch& b) {
+    if (a.distance != b.distance)
+      return a.distance < b.distance;
+    return a.palette < b.palette;
+  };
+
+  if (max_results >= 0 && max_results < matches.size())
+  {
+    std::partial_sort(matches.begin(), matches.begin() + max_results, matches.end(), closer);
+    matches.resize(max_results);
+  }
+  else
+  {
+    std::sort(matches.begin(), matches.end(), closer);
+  }
+}
+
+QVector<ColorPaletteModel::PaletteMatch>
+    ColorPaletteModel::similarPalettes(const ColorPalette& palette, int max_results) const
+{
+  Private::Signature sig = Private::signature(palette);
+  QVector<PaletteMatch> matches;
+  matches.reserve(p->signatures.size());
+  for (int i = 0; i < p->signatures.size(); i++)
+    matches.push_back({i, Private::signature_distance(sig, p->signatures[i])});
+  rank_palettes(matches, max_results);
+  return matches;
+}
+
+QVector<ColorPaletteModel::PaletteMatch>
+    ColorPaletteModel::similarPalettes(int index, int max_results) const
+{
+  const Private::Signature& sig = p->signatures[index];
+  QVector<PaletteMatch> matches;
+  matches.reserve(p->signatures.size());
+  for (int i = 0; i < p->signatures.size(); i++)
+    if (i != index)
+      matches.push_back({i, Private::signature_distance(sig, p->signatures[i])});
+  rank_palettes(matches, max_results);
+  return matches;
+}
+
+QVector<ColorPaletteModel::NameMatch>
+    ColorPaletteModel::findNames(const QString& text, int max_results, bool fuzzy) const
+{
+  QVector<NameMatch> matches;
+  QString query = text.toCaseFolded();
+  if (query.isEmpty() || max_results == 0)
+    return matches;
+
+  p->ensure_names();
+
+  // Names containing the query also contain the previous query if the
+  // latter is a substring, otherwise narrow the candidates with the rarest
+  // trigram of the query
+  QVector<int> candidates;
+  bool all_names = false;
+  if (!p->last_query.isEmpty() && query.contains(p->last_query))
+  {
+    candidates = p->last_substring_matches;
+  }
+  else if (query.size() >= 3)
+  {
+    const QVector<int>* rarest = nullptr;
+    for (quint64 gram : Private::trigrams(query, false))
+    {
+      auto it = p->name_trigrams.constFind(gram);
+      if (it == p->name_trigrams.constEnd())
+      {
+        static const QVector<int> none;
+        rarest = &none;
+        break;
+      }
+      if (!rarest || it->size() < rarest->size())
+        rarest = &*it;
+    }
+    candidates = *rarest;
+  }
+  else
+  {
+    all_names = true;
+  }
+
+  QVector<int> substring;
+  auto check = [&](int name) {
+    if (p->names[name].folded.contains(query))
+      substring.push_back(name);
+  };
+  if (all_names)
+  {
+    for (int i = 0; i < p->names.size(); i++)
+      check(i);
+  }
+  else
+  {
+    for (int name : candidates)
+      check(name);
+  }
+
+  p->last_query = query;
+  p->last_substring_matches = substring;
+
+  // (name, score) pairs
+  QVector<QPair<int, float>> scored;
+  for (int name : substring)
+    scored.push_back({name, 1.f});
+
+  if (fuzzy && query.size() >= 3)
+  {
+    // Dice coefficient on the padded trigrams
+    QVector<quint64> grams = Private::trigrams(query, true);
+    QHash<int, int> shared;
+    for (quint64 gram : grams)
+    {
+      auto it = p->name_trigrams.constFind(gram);
+      if (it != p->name_trigrams.constEnd())
+        for (int name : *it)
+          shared[name]++;
+    }
+
+    std::sort(substring.begin(), substring.end());
+    for (auto it = shared.cbegin(); it != shared.cend(); ++it)
+    {
+      float score = 2.f * it.value() / (grams.size() + p->names[it.key()].trigrams);
+      if (score >= Private::fuzzy_threshold
+          && !std::binary_search(substring.begin(), substring.end(), it.key()))
+        scored.push_back({it.key(), qMin(score, 0.99f)});
+    }
+  }
+
+  auto better = [this](const QPair<int, float>& a, const QPair<int, float>& b) {
+    if (a.second != b.second)
+      return a.second > b.second;
+    int length_a = p->names[a.first].folded.size();
+    int length_b = p->names[b.first].folded.size();
+    if (length_a != length_b)
+      return length_a < length_b;
+    return a.first < b.first;
+  };
+
+  if (max_results > 0 && max_results < scored.size())
+  {
+    std::partial_sort(scored.begin(), scored.begin() + max_results, scored.end(), better);
+    scored.resize(max_results);
+  }
+  else
+  {
+    std::sort(scored.begin(), scored.end(), better);
+  }
+
+  matches.reserve(scored.size());
+  for (const auto& match : scored)
+  {
+    const Private::NameEntry& entry = p->names[match.first];
+    matches.push_back({entry.palette, entry.index, match.second});
+  }
+
+  return matches;
+}
+
 } // namespace color_widgets
@@ -28,6 +28,7 @@
 #include <QImageReader>
 #include <QInputDialog>
 #include <QMessageBox>
+#include <QProgressDialog>
 
 #include <wobjectimpl.h>
 
@@ -79,6 +80,34 @@ public:
     return false;
   }
 
+  /**
+   * \brief Adds a palette with the main colors of an image (of any size)
+   */
+  bool extractImageColors(const QString& file, QWidget* parent)
+  {
+    QProgressDialog progress(
+        ColorPaletteWidget::tr("Extracting colors from %1").arg(QFileInfo(file).fileName()),
+        ColorPaletteWidget::tr("Cancel"),
+        0,
+        1000,
+        parent);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+
+    ColorPalette palette;
+    bool loaded = palette.loadImageColors(file, 256, [&progress](qint64 done, qint64 total) {
+      progress.setValue(total > 0 ? int(done * 1000 / total) : 0);
+      return !progress.wasCanceled();
+    });
+    if (!loaded)
+      return progress.wasCanceled();
+
+    palette.setName(QFileInfo(file).baseName());
+    palette.setFileName(file + ".gpl");
+    addPalette(palette);
+    return true;
+  }
+
   bool openGpl(const QString& file)
   {
     int existing = model->indexFromFile(file);
@@ -98,10 +127,12 @@ public:
     return false;
   }
 
-  bool openPalette(const QString& file, int type)
+  bool openPalette(const QString& file, int type, QWidget* parent)
   {
     if (type == 1)
       return openImage(file);
+    if (type == 2)
+      return extractImageColors(file, parent);
     return openGpl(file);
   }
 };
@@ -228,6 +259,7 @@ ColorPaletteWidget::ColorPaletteWidget(QWidget* parent) : QWidget(parent), p(new
 
       QStringList file_formats = QStringList() << tr("GIMP Palettes (*.gpl)")
                                                << tr("Palette Image (%1)").arg(image_formats)
+                                               << tr("Image Colors (%1)").arg(image_formats)
                                                << tr("All Files (*)");
       QFileDialog open_dialog(this, tr("Open Palette"), default_dir);
       open_dialog.setFileMode(QFileDialog::ExistingFile);
@@ -240,7 +272,7 @@ ColorPaletteWidget::ColorPaletteWidget(QWidget* parent) : QWidget(parent), p(new
       int type = file_formats.indexOf(open_dialog.selectedNameFilter());
       QString file_name = open_dialog.selectedFiles()[0];
 
-      if (!p->openPalette(file_name, type))
+      if (!p->openPalette(file_name, type, this))
       {
         QMessageBox::warning(
             this, tr("Open Palette"), tr("Failed to load the palette file\n%1").arg(file_name));
@@ -23,6 +23,7 @@
 #include "color_preview.hpp"
 
 #include "color_utils.hpp"
+#include "update_guard.hpp"
 
 #include <QDrag>
 #include <QMimeData>
@@ -43,6 +44,7 @@ public:
   QColor comparison;        ///< comparison color
   QBrush back;              ///< Background brush, visible on a transparent color
   DisplayMode display_mode; ///< How the color(s) are to be shown
+  bool updating = false;    ///< Whether setColor() is running
 
   Private() : col(Qt::red), back(Qt::darkGray, Qt::DiagCrossPattern), display_mode(NoAlpha) { }
 };
@@ -135,6 +137,10 @@ void ColorPreview::paint(QPainter& painter, QRect rect) const
 
 void ColorPreview::setColor(const QColor& c)
 {
+  detail::update_guard guard(p->updating);
+  if (!guard.enter(!detail::fuzzy_same(c, p->col)))
+    return;
+
   p->col = c;
   update();
   colorChanged(c);
@@ -0,0 +1,169 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "color_state.hpp"
+
+#include <wobjectimpl.h>
+
+W_OBJECT_IMPL(color_widgets::ColorState)
+namespace color_widgets
+{
+
+class ColorState::Private
+{
+public:
+  ColorState* owner;
+  ColorF color = ColorF::fromRgbF(0, 0, 0);
+  quint64 version = 0;
+  QObject* source = nullptr;
+
+  int update_depth = 0;
+  bool notifying = false;
+  Components pending;
+  QObject* pending_source = nullptr;
+
+  explicit Private(ColorState* owner) : owner(owner) { }
+
+  static Components difference(const ColorF& a, const ColorF& b)
+  {
+    Components changes;
+    if (a.r != b.r)
+      changes |= Red;
+    if (a.g != b.g)
+      changes |= Green;
+    if (a.b != b.b)
+      changes |= Blue;
+    if (a.h != b.h)
+      changes |= Hue;
+    if (a.s != b.s)
+      changes |= Saturation;
+    if (a.v != b.v)
+      changes |= Value;
+    if (a.a != b.a)
+      changes |= Alpha;
+    return changes;
+  }
+
+  void set(const ColorF& new_color, QObject* new_source)
+  {
+    Components changes = difference(color, new_color);
+    if (!changes)
+      return;
+
+    color = new_color;
+    if (!pending)
+      pending_source = new_source;
+    else if (pending_source != new_source)
+      pending_source = nullptr;
+    pending |= changes;
+    notify();
+  }
+
+  /**
+   * \brief Emits changed() for the pending changes, unless delayed
+   *
+   * Changes made by the handlers are emitted in a loop once they return.
+   */
+  void notify()
+  {
+    if (update_depth > 0 || notifying)
+      return;
+
+    notifying = true;
+    while (pending)
+    {
+      Components changes = pending;
+      source = pending_source;
+      pending = Components();
+      pending_source = nullptr;
+      version++;
+      owner->changed(changes);
+    }
+    notifying = false;
+  }
+};
+
+ColorState::ColorState(QObject* parent) : QObject(parent), p(new Private(this)) { }
+
+ColorState::~ColorState()
+{
+  delete p;
+}
+
+ColorF ColorState::colorF() const
+{
+  return p->color;
+}
+
+QColor ColorState::color() const
+{
+  return p->color.toColor();
+}
+
+quint64 ColorState::version() const
+{
+  return p->version;
+}
+
+QObject* ColorState::source() const
+{
+  return p->source;
+}
+
+void ColorState::beginUpdate()
+{
+  p->update_depth++;
+}
+
+void ColorState::endUpdate()
+{
+  if (p->update_depth > 0 && --p->update_depth == 0)
+    p->notify();
+}
+
+void ColorState::setColorF(const ColorF& color, QObject* source)
+{
+  p->set(color, source);
+}
+
+void ColorState::setColor(const QColor& color, QObject* source)
+{
+  p->set(ColorF::fromColor(color), source);
+}
+
+void ColorState::setRgbF(float red, float green, float blue, QObject* source)
+{
+  p->set(ColorF::fromRgbF(red, green, blue, p->color.a, p->color.h), source);
+}
+
+void ColorState::setHsvF(float hue, float saturation, float value, QObject* source)
+{
+  p->set(ColorF::fromHsvF(hue, saturation, value, p->color.a), source);
+}
+
+void ColorState::setAlphaF(float alpha, QObject* source)
+{
+  ColorF color = p->color;
+  color.a = alpha;
+  p->set(color, source);
+}
+
+} // namespace color_widgets
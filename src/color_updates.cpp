@@ -0,0 +1,94 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "color_updates.hpp"
+
+#include "update_guard.hpp"
+
+#include <QtMath>
+
+namespace color_widgets
+{
+
+static qreal tolerance = 0.5 / 255;
+static ColorUpdateStats stats;
+
+qreal colorTolerance()
+{
+  return tolerance;
+}
+
+void setColorTolerance(qreal value)
+{
+  tolerance = qMax<qreal>(0, value);
+}
+
+ColorUpdateStats colorUpdateStats()
+{
+  return stats;
+}
+
+void resetColorUpdateStats()
+{
+  stats = ColorUpdateStats();
+}
+
+namespace detail
+{
+
+bool fuzzy_same(qreal a, qreal b)
+{
+  return qAbs(a - b) <= tolerance;
+}
+
+bool fuzzy_same(const QColor& a, const QColor& b)
+{
+  if (!a.isValid() || !b.isValid())
+    return a.isValid() == b.isValid();
+
+  QColor rgb_a = a.toRgb();
+  QColor rgb_b = b.toRgb();
+  return fuzzy_same(rgb_a.redF(), rgb_b.redF()) && fuzzy_same(rgb_a.greenF(), rgb_b.greenF())
+         && fuzzy_same(rgb_a.blueF(), rgb_b.blueF()) && fuzzy_same(rgb_a.alphaF(), rgb_b.alphaF());
+}
+
+bool update_guard::enter(bool changed)
+{
+  if (updating)
+  {
+    stats.reentrant++;
+    return false;
+  }
+
+  if (!changed)
+  {
+    stats.suppressed++;
+    return false;
+  }
+
+  stats.executed++;
+  updating = true;
+  entered = true;
+  return true;
+}
+
+} // namespace detail
+} // namespace color_widgets
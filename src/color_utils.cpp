@@ -24,68 +24,11 @@
 #include <QImage>
 #include <QPainter>
 
-#include <cmath>
-
 namespace color_widgets
 {
 namespace detail
 {
 
-QColor color_from_lch(color_float hue, color_float chroma, color_float luma, color_float alpha)
-{
-  color_float h1 = hue * 6;
-  color_float x = chroma * (1 - qAbs(std::fmod(h1, 2) - 1));
-  QColor col;
-  if (h1 >= 0 && h1 < 1)
-    col = QColor::fromRgbF(chroma, x, 0);
-  else if (h1 < 2)
-    col = QColor::fromRgbF(x, chroma, 0);
-  else if (h1 < 3)
-    col = QColor::fromRgbF(0, chroma, x);
-  else if (h1 < 4)
-    col = QColor::fromRgbF(0, x, chroma);
-  else if (h1 < 5)
-    col = QColor::fromRgbF(x, 0, chroma);
-  else if (h1 < 6)
-    col = QColor::fromRgbF(chroma, 0, x);
-
-  color_float m = luma - color_lumaF(col);
-
-  return QColor::fromRgbF(
-      qBound(0.0, col.redF() + m, 1.0),
-      qBound(0.0, col.greenF() + m, 1.0),
-      qBound(0.0, col.blueF() + m, 1.0),
-      alpha);
-}
-
-QColor color_from_hsl(color_float hue, color_float sat, color_float lig, color_float alpha)
-{
-  color_float chroma = (1 - qAbs(2 * lig - 1)) * sat;
-  color_float h1 = hue * 6;
-  color_float x = chroma * (1 - qAbs(std::fmod(h1, 2) - 1));
-  QColor col;
-  if (h1 >= 0 && h1 < 1)
-    col = QColor::fromRgbF(chroma, x, 0);
-  else if (h1 < 2)
-    col = QColor::fromRgbF(x, chroma, 0);
-  else if (h1 < 3)
-    col = QColor::fromRgbF(0, chroma, x);
-  else if (h1 < 4)
-    col = QColor::fromRgbF(0, x, chroma);
-  else if (h1 < 5)
-    col = QColor::fromRgbF(x, 0, chroma);
-  else if (h1 < 6)
-    col = QColor::fromRgbF(chroma, 0, x);
-
-  color_float m = lig - chroma / 2;
-
-  return QColor::fromRgbF(
-      qBound(0.0, col.redF() + m, 1.0),
-      qBound(0.0, col.greenF() + m, 1.0),
-      qBound(0.0, col.blueF() + m, 1.0),
-      alpha);
-}
-
 QPixmap alpha_pixmap()
 {
   QImage im(32, 32, QImage::Format_ARGB32);
@@ -99,5 +42,20 @@ QPixmap alpha_pixmap()
   return QPixmap::fromImage(im);
 }
 
+const quint8* srgb_encode_table()
+{
+  struct Table
+  {
+    quint8 values[srgb_encode_steps + 1];
+    Table()
+    {
+      for (int i = 0; i <= srgb_encode_steps; i++)
+        values[i] = quint8(linear_to_srgb(float(i) / srgb_encode_steps));
+    }
+  };
+  static const Table table;
+  return table.values;
+}
+
 } // namespace detail
 } // namespace color_widgets
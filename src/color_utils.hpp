@@ -20,10 +20,16 @@
  *
  */
 #pragma once
+#include "color_core.hpp"
+
 #include <QColor>
+#include <QImage>
+#include <QPainter>
 #include <QPixmap>
 #include <qmath.h>
 
+class QWidget;
+
 namespace color_widgets
 {
 namespace detail
@@ -35,18 +41,39 @@ using color_float = qreal;
 using color_float = float;
 #endif
 
+inline rgb_f color_rgbF(const QColor& c)
+{
+  // A single conversion for colors that aren't RGB, rather than one per component
+  QColor rgb = c.toRgb();
+  return {float(rgb.redF()), float(rgb.greenF()), float(rgb.blueF())};
+}
+
 inline qreal color_chromaF(const QColor& c)
 {
-  qreal max = qMax(c.redF(), qMax(c.greenF(), c.blueF()));
-  qreal min = qMin(c.redF(), qMin(c.greenF(), c.blueF()));
-  return max - min;
+  return color_chroma(color_rgbF(c));
 }
 
 inline qreal color_lumaF(const QColor& c)
 {
-  return 0.30 * c.redF() + 0.59 * c.greenF() + 0.11 * c.blueF();
+  return color_luma(color_rgbF(c));
+}
+
+inline QColor color_from_lch(
+    color_float hue, color_float chroma, color_float luma, color_float alpha = 1)
+{
+  rgb_f c = rgb_from_lch(hue, chroma, luma);
+  return QColor::fromRgbF(c.r, c.g, c.b, alpha);
+}
+
+/**
+ * \brief Like color_from_lch() but reducing chroma for colors out of gamut
+ */
+inline QColor color_from_lch_mapped(
+    color_float hue, color_float chroma, color_float luma, color_float alpha = 1)
+{
+  rgb_f c = rgb_from_lch_mapped(hue, chroma, luma);
+  return QColor::fromRgbF(c.r, c.g, c.b, alpha);
 }
-QColor color_from_lch(color_float hue, color_float chroma, color_float luma, color_float alpha = 1);
 
 inline QColor rainbow_lch(qreal hue)
 {
@@ -60,24 +87,76 @@ inline QColor rainbow_hsv(qreal hue)
 
 inline qreal color_lightnessF(const QColor& c)
 {
-  return (qMax(c.redF(), qMax(c.greenF(), c.blueF()))
-          + qMin(c.redF(), qMin(c.greenF(), c.blueF())))
-         / 2;
+  return color_lightness(color_rgbF(c));
 }
 
 inline qreal color_HSL_saturationF(const QColor& col)
 {
-  qreal c = color_chromaF(col);
-  qreal l = color_lightnessF(col);
-  if (qFuzzyCompare(l + 1, 1) || qFuzzyCompare(l + 1, 2))
-    return 0;
-  return c / (1 - qAbs(2 * l - 1));
+  return color_hsl_saturation(color_rgbF(col));
 }
 
-QColor color_from_hsl(color_float hue, color_float sat, color_float lig, color_float alpha = 1);
+inline QColor color_from_hsl(
+    color_float hue, color_float sat, color_float lig, color_float alpha = 1)
+{
+  rgb_f c = rgb_from_hsl(hue, sat, lig);
+  return QColor::fromRgbF(c.r, c.g, c.b, alpha);
+}
+
+/**
+ * \brief Converts an sRGB color to OKLab (alpha is ignored)
+ */
+inline oklab color_to_oklab(QRgb rgb)
+{
+  return srgb_to_oklab(qRed(rgb), qGreen(rgb), qBlue(rgb));
+}
 
 QPixmap alpha_pixmap();
 
+/// Number of steps in srgb_encode_table()
+const int srgb_encode_steps = 4095;
+
+/**
+ * \brief 8 bit sRGB values of linear light quantized to srgb_encode_steps
+ *
+ * The steps are finer than the distance between the darkest sRGB values so
+ * every 8 bit value is reachable.
+ */
+const quint8* srgb_encode_table();
+
+/**
+ * \brief Cached copy of an image as seen with the current color vision simulation
+ *
+ * The simulation runs again only when the source image or the simulation
+ * change, with no simulation the source is returned as it is.
+ */
+class simulated_image
+{
+public:
+  const QImage& operator()(const QImage& source);
+
+private:
+  QImage image;
+  qint64 source_key = 0;
+  unsigned generation = 0;
+};
+
+/**
+ * \brief Painter for paintEvent() applying the color vision simulation
+ *
+ * With a simulation active it paints on an image, which is simulated and
+ * drawn on the widget on destruction.
+ */
+class simulated_painter : public QPainter
+{
+public:
+  explicit simulated_painter(QWidget* widget);
+  ~simulated_painter();
+
+private:
+  QWidget* widget;
+  QImage image;
+};
+
 const double selector_radius = 6;
 } // namespace detail
 } // namespace color_widgets
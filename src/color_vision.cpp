@@ -0,0 +1,210 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "color_vision.hpp"
+
+#include "color_utils.hpp"
+#include "parallel.hpp"
+
+#include <QApplication>
+#include <QWidget>
+
+#include <cmath>
+
+namespace color_widgets
+{
+
+static ColorVisionDeficiency simulation = NormalVision;
+/// Incremented when the simulation changes, to invalidate simulated_image
+static unsigned simulation_generation = 0;
+
+/**
+ * \brief Linear RGB transforms by Machado et al. (2009), severity 1
+ */
+static const float simulation_matrices[][9] = {
+    // Protanopia
+    {0.152286f, 1.052583f, -0.204868f, 0.114503f, 0.786281f, 0.099216f, -0.003882f, -0.048116f,
+     1.051998f},
+    // Deuteranopia
+    {0.367322f, 0.860646f, -0.227968f, 0.280085f, 0.672501f, 0.047413f, -0.011820f, 0.042940f,
+     0.968881f},
+    // Tritanopia
+    {1.255528f, -0.076749f, -0.178779f, -0.078411f, 0.930809f, 0.147602f, 0.004733f, 0.691367f,
+     0.303900f},
+};
+
+/**
+ * \brief Simulates a run of pixels
+ *
+ * Channels are linearized and encoded with lookup tables, the matrix product
+ * works on plain float arrays so the compiler can vectorize it.
+ */
+template<bool Premultiplied>
+static void simulate_pixels(QRgb* pixels, int count, const float* m, const quint8* encode)
+{
+  const int chunk = 256;
+  float r[chunk], g[chunk], b[chunk];
+  int ri[chunk], gi[chunk], bi[chunk];
+
+  for (int start = 0; start < count; start += chunk)
+  {
+    QRgb* run = pixels + start;
+    int size = qMin(chunk, count - start);
+
+    for (int i = 0; i < size; i++)
+    {
+      QRgb pixel = Premultiplied ? qUnpremultiply(run[i]) : run[i];
+      r[i] = detail::srgb_linear.values[qRed(pixel)];
+      g[i] = detail::srgb_linear.values[qGreen(pixel)];
+      b[i] = detail::srgb_linear.values[qBlue(pixel)];
+    }
+
+    for (int i = 0; i < size; i++)
+    {
+      float lr = m[0] * r[i] + m[1] * g[i] + m[2] * b[i];
+      float lg = m[3] * r[i] + m[4] * g[i] + m[5] * b[i];
+      float lb = m[6] * r[i] + m[7] * g[i] + m[8] * b[i];
+      ri[i] = int(detail::math::clamp(lr, 0.f, 1.f) * detail::srgb_encode_steps + 0.5f);
+      gi[i] = int(detail::math::clamp(lg, 0.f, 1.f) * detail::srgb_encode_steps + 0.5f);
+      bi[i] = int(detail::math::clamp(lb, 0.f, 1.f) * detail::srgb_encode_steps + 0.5f);
+    }
+
+    for (int i = 0; i < size; i++)
+    {
+      QRgb pixel = qRgba(encode[ri[i]], encode[gi[i]], encode[bi[i]], qAlpha(run[i]));
+      run[i] = Premultiplied ? qPremultiply(pixel) : pixel;
+    }
+  }
+}
+
+ColorVisionDeficiency colorVisionSimulation()
+{
+  return simulation;
+}
+
+void setColorVisionSimulation(ColorVisionDeficiency deficiency)
+{
+  if (deficiency == simulation)
+    return;
+
+  simulation = deficiency;
+  simulation_generation++;
+
+  if (qobject_cast<QApplication*>(QCoreApplication::instance()))
+  {
+    for (QWidget* widget : QApplication::allWidgets())
+      widget->update();
+  }
+}
+
+void simulateColorVision(QImage& image, ColorVisionDeficiency deficiency)
+{
+  if (deficiency == NormalVision || image.isNull())
+    return;
+
+  QImage::Format format = image.format();
+  if (format != QImage::Format_RGB32 && format != QImage::Format_ARGB32
+      && format != QImage::Format_ARGB32_Premultiplied)
+  {
+    image = image.convertToFormat(QImage::Format_ARGB32);
+    format = QImage::Format_ARGB32;
+  }
+
+  const float* matrix = simulation_matrices[deficiency - 1];
+  const quint8* encode = detail::srgb_encode_table();
+  bool premultiplied = format == QImage::Format_ARGB32_Premultiplied;
+  int width = image.width();
+  // bits() detaches, scanLine() can't be called from the threads
+  uchar* bits = image.bits();
+  qptrdiff stride = image.bytesPerLine();
+
+  int threads = detail::thread_count(0, int(qint64(width) * image.height() / 65536));
+  detail::parallel_for(0, image.height(), threads, [&](int from, int to) {
+    for (int y = from; y < to; y++)
+    {
+      QRgb* row = reinterpret_cast<QRgb*>(bits + y * stride);
+      if (premultiplied)
+        simulate_pixels<true>(row, width, matrix, encode);
+      else
+        simulate_pixels<false>(row, width, matrix, encode);
+    }
+  });
+}
+
+QColor simulateColorVision(const QColor& color, ColorVisionDeficiency deficiency)
+{
+  if (deficiency == NormalVision || !color.isValid())
+    return color;
+
+  QRgb rgb = color.rgba();
+  const float* matrix = simulation_matrices[deficiency - 1];
+  simulate_pixels<false>(&rgb, 1, matrix, detail::srgb_encode_table());
+  return QColor::fromRgba(rgb);
+}
+
+namespace detail
+{
+
+const QImage& simulated_image::operator()(const QImage& source)
+{
+  if (simulation == NormalVision)
+  {
+    image = QImage();
+    return source;
+  }
+
+  if (source.cacheKey() != source_key || generation != simulation_generation)
+  {
+    source_key = source.cacheKey();
+    generation = simulation_generation;
+    image = source;
+    simulateColorVision(image, simulation);
+  }
+  return image;
+}
+
+simulated_painter::simulated_painter(QWidget* widget) : widget(widget)
+{
+  if (simulation == NormalVision)
+  {
+    begin(widget);
+    return;
+  }
+
+  qreal ratio = widget->devicePixelRatioF();
+  image = QImage(widget->size() * ratio, QImage::Format_ARGB32_Premultiplied);
+  image.setDevicePixelRatio(ratio);
+  image.fill(Qt::transparent);
+  begin(&image);
+}
+
+simulated_painter::~simulated_painter()
+{
+  if (image.isNull())
+    return;
+
+  end();
+  simulateColorVision(image, simulation);
+  QPainter(widget).drawImage(0, 0, image);
+}
+
+} // namespace detail
+} // namespace color_widgets
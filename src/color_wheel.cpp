@@ -21,7 +21,10 @@
  */
 #include "color_wheel.hpp"
 
+#include "color_palette.hpp"
 #include "color_utils.hpp"
+#include "gamut_mapping.hpp"
+#include "update_guard.hpp"
 
 #include <QDragEnterEvent>
 #include <QLineF>
@@ -29,8 +32,11 @@
 #include <QMouseEvent>
 #include <QPainter>
 #include <QPainterPath>
+#include <QPointer>
+#include <QTimer>
 
 #include <cmath>
+#include <vector>
 #include <wobjectimpl.h>
 
 W_OBJECT_IMPL(color_widgets::ColorWheel)
@@ -41,13 +47,159 @@ enum MouseStatus
 {
   Nothing,
   DragCircle,
-  DragSquare
+  DragSquare,
+  DragMarker
 };
 
 static const ColorWheel::DisplayFlags hard_default_flags
     = ColorWheel::SHAPE_TRIANGLE | ColorWheel::ANGLE_ROTATING | ColorWheel::COLOR_HSV;
 static ColorWheel::DisplayFlags default_flags = hard_default_flags;
 
+/// Number of hue and saturation steps in the disk color table
+static const int disk_hue_steps = 360;
+static const int disk_sat_steps = 64;
+
+/**
+ * \brief Hue and saturation table indices of the pixels of a disk
+ *
+ * It only depends on the size of the disk, so changing the colors only needs
+ * a table lookup per pixel.
+ */
+struct polar_map
+{
+  int size = 0;
+  std::vector<quint16> hue; ///< Index in [0, disk_hue_steps)
+  std::vector<quint8> sat;  ///< Index in [0, disk_sat_steps]
+
+  void resize(int new_size)
+  {
+    size = new_size;
+    hue.resize(size * size);
+    sat.resize(size * size);
+    qreal radius = size / 2.0;
+    for (int y = 0; y < size; y++)
+    {
+      for (int x = 0; x < size; x++)
+      {
+        qreal dx = x + 0.5 - radius;
+        qreal dy = radius - y - 0.5;
+        // Same angle as QLineF::angle(), used by the hue ring
+        qreal angle = std::atan2(dy, dx) / (2 * M_PI);
+        if (angle < 0)
+          angle += 1;
+        qreal distance = qMin(std::sqrt(dx * dx + dy * dy) / radius, 1.0);
+        hue[y * size + x] = quint16(qRound(angle * disk_hue_steps) % disk_hue_steps);
+        sat[y * size + x] = quint8(qRound(distance * disk_sat_steps));
+      }
+    }
+  }
+};
+
+/**
+ * \brief Colors of the disk by hue and saturation, for a given value
+ */
+struct disk_table
+{
+  qreal val = -1;
+  ColorWheel::DisplayFlags color_flags;
+  bool gamut_mapping = false;
+  bool gamut_overlay = false;
+  std::vector<QRgb> colors;         ///< disk_sat_steps + 1 colors per hue
+  std::vector<quint8> out_of_gamut; ///< Same layout as colors, LCH only
+  qint64 image_key = 0;             ///< cacheKey() of the image rendered from the table
+};
+
+/// Radius of palette markers
+static const qreal marker_radius = 5;
+
+/**
+ * \brief A palette color shown on the wheel
+ */
+struct palette_marker
+{
+  qreal hue, sat, val; ///< Components in the color space of the wheel
+  QPointF pos;         ///< Position relative to the center of the wheel
+  QColor color;
+};
+
+/**
+ * \brief Buckets markers by position so hit tests only look at nearby ones
+ *
+ * The cells are at least as large as the search radius, so a search only
+ * needs the cell of the point and its neighbours.
+ */
+class marker_grid
+{
+public:
+  /**
+   * \param extent Markers are expected within [-extent, extent] on both axes
+   */
+  void build(const std::vector<palette_marker>& markers, qreal extent, qreal cell_size)
+  {
+    origin = -extent;
+    cell = cell_size;
+    side = qMax(1, int(std::ceil(2 * extent / cell)));
+
+    // Counting sort of the markers by cell
+    starts.assign(side * side + 1, 0);
+    for (const auto& marker : markers)
+      starts[cell_index(marker.pos) + 1]++;
+    for (int i = 1; i < int(starts.size()); i++)
+      starts[i] += starts[i - 1];
+
+    std::vector<int> next(starts.begin(), starts.end() - 1);
+    indices.resize(markers.size());
+    for (int i = 0; i < int(markers.size()); i++)
+      indices[next[cell_index(markers[i].pos)]++] = i;
+  }
+
+  /**
+   * \brief Index of the marker closest to \p pos within \p radius, or -1
+   */
+  int find(const std::vector<palette_marker>& markers, const QPointF& pos, qreal radius) const
+  {
+    if (indices.empty())
+      return -1;
+
+    int center = cell_index(pos);
+    int cx = center % side, cy = center / side;
+    int found = -1;
+    qreal best = radius * radius;
+    for (int y = qMax(0, cy - 1); y <= qMin(side - 1, cy + 1); y++)
+    {
+      for (int x = qMax(0, cx - 1); x <= qMin(side - 1, cx + 1); x++)
+      {
+        int c = y * side + x;
+        for (int i = starts[c]; i < starts[c + 1]; i++)
+        {
+          QPointF delta = markers[indices[i]].pos - pos;
+          qreal distance = QPointF::dotProduct(delta, delta);
+          if (distance <= best)
+          {
+            best = distance;
+            found = indices[i];
+          }
+        }
+      }
+    }
+    return found;
+  }
+
+private:
+  int cell_index(const QPointF& pos) const
+  {
+    int x = qBound(0, int((pos.x() - origin) / cell), side - 1);
+    int y = qBound(0, int((pos.y() - origin) / cell), side - 1);
+    return y * side + x;
+  }
+
+  qreal origin = 0;
+  qreal cell = 1;
+  int side = 1;
+  std::vector<int> starts;  ///< Offset in indices of each cell, plus the end
+  std::vector<int> indices; ///< Marker indices sorted by cell
+};
+
 class ColorWheel::Private
 {
 private:
@@ -57,8 +209,10 @@ public:
   qreal hue, sat, val;
   unsigned int wheel_width;
   MouseStatus mouse_status;
-  QPixmap hue_ring;
+  QImage hue_ring;
   QImage inner_selector;
+  detail::simulated_image simulated_ring;
+  detail::simulated_image simulated_selector;
   DisplayFlags display_flags;
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
   QColor (*color_from)(qreal, qreal, qreal, qreal);
@@ -67,6 +221,23 @@ public:
 #endif
   QColor (*rainbow_from_hue)(qreal);
   int max_size = 128;
+  bool gamut_mapping = false;
+  bool gamut_overlay = false;
+  bool updating = false;
+  polar_map disk_map;
+  disk_table disk;
+  QPointer<ColorPalette> palette;
+  std::vector<palette_marker> markers;
+  marker_grid grid;
+  int drag_marker = -1;
+  bool drag_rotates = false;
+  qreal drag_start_angle = 0;
+  std::vector<qreal> drag_start_hues;
+  QPoint drag_start_pos;
+  QPointF drag_offset; ///< From the cursor to the dragged marker
+  bool drag_moved = false;
+  QTimer push_timer;
+  bool pushing = false;
 
   Private(ColorWheel* widget)
       : w(widget)
@@ -79,6 +250,10 @@ public:
       , color_from(&QColor::fromHsvF)
       , rainbow_from_hue(&detail::rainbow_hsv)
   {
+    // Drags write to the palette at most once per frame
+    push_timer.setSingleShot(true);
+    push_timer.setInterval(16);
+    QObject::connect(&push_timer, &QTimer::timeout, w, [this] { push_markers(); });
   }
 
   /// Calculate outer wheel radius from idget center
@@ -96,6 +271,9 @@ public:
   /// Calculate the side of the inner triangle
   qreal triangle_side() const { return inner_radius() * qSqrt(3); }
 
+  /// Calculate the diameter of the inner disk
+  qreal disk_size() const { return inner_radius() * 2; }
+
   /// return line from center to given point
   QLineF line_to_point(const QPoint& p) const
   {
@@ -108,6 +286,20 @@ public:
     QSize size(width, width);
     inner_selector = QImage(size, QImage::Format_RGB32);
 
+    if (display_flags & ColorWheel::COLOR_LCH)
+    {
+      std::vector<float> chroma(width), luma(width);
+      for (int x = 0; x < width; ++x)
+        chroma[x] = float(x) / width;
+      for (int y = 0; y < width; ++y)
+      {
+        std::fill(luma.begin(), luma.end(), float(y) / width);
+        QRgb* row = reinterpret_cast<QRgb*>(inner_selector.scanLine(y));
+        render_lch_line(chroma.data(), luma.data(), width, y, row);
+      }
+      return;
+    }
+
     for (int y = 0; y < width; ++y)
     {
       for (int x = 0; x < width; ++x)
@@ -132,6 +324,26 @@ public:
     qreal ycenter = size.height() / 2;
     inner_selector = QImage(size.toSize(), QImage::Format_RGB32);
 
+    if (display_flags & ColorWheel::COLOR_LCH)
+    {
+      int height = inner_selector.height();
+      std::vector<float> chroma(height), luma(height);
+      std::vector<QRgb> column(height);
+      for (int x = 0; x < inner_selector.width(); x++)
+      {
+        qreal pval = x / size.height();
+        qreal slice_h = size.height() * pval;
+        qreal ymin = ycenter - slice_h / 2;
+        for (int y = 0; y < height; y++)
+          chroma[y] = qBound(0.0, (y - ymin) / slice_h, 1.0);
+        std::fill(luma.begin(), luma.end(), float(pval));
+        render_lch_line(chroma.data(), luma.data(), height, x, column.data());
+        for (int y = 0; y < height; y++)
+          inner_selector.setPixel(x, y, column[y]);
+      }
+      return;
+    }
+
     for (int x = 0; x < inner_selector.width(); x++)
     {
       qreal pval = x / size.height();
@@ -146,11 +358,140 @@ public:
     }
   }
 
+  /**
+   * \brief Renders a line of the selector in LCH, with the gamut options
+   * \param offset Position of the line, to line up out of gamut stripes
+   */
+  void render_lch_line(const float* chroma, const float* luma, int count, int offset, QRgb* out)
+  {
+    std::vector<float> hues(count, hue);
+    std::vector<quint8> out_of_gamut(count);
+    detail::lch_to_rgb(hues.data(), chroma, luma, count, out, out_of_gamut.data(), gamut_mapping);
+
+    if (gamut_overlay)
+    {
+      for (int i = 0; i < count; i++)
+        if (out_of_gamut[i])
+          out[i] = detail::out_of_gamut_marker(out[i], i, offset);
+    }
+  }
+
+  /**
+   * \brief Fills the disk table with the colors for the current value
+   */
+  void render_disk_table()
+  {
+    const int row = disk_sat_steps + 1;
+    disk.colors.resize(disk_hue_steps * row);
+    disk.out_of_gamut.assign(disk_hue_steps * row, 0);
+
+    if (display_flags & ColorWheel::COLOR_LCH)
+    {
+      std::vector<float> hues(row), chroma(row), luma(row, float(val));
+      for (int s = 0; s < row; s++)
+        chroma[s] = float(s) / disk_sat_steps;
+      for (int h = 0; h < disk_hue_steps; h++)
+      {
+        std::fill(hues.begin(), hues.end(), float(h) / disk_hue_steps);
+        detail::lch_to_rgb(
+            hues.data(),
+            chroma.data(),
+            luma.data(),
+            row,
+            &disk.colors[h * row],
+            &disk.out_of_gamut[h * row],
+            gamut_mapping);
+      }
+    }
+    else
+    {
+      bool hsl = display_flags & ColorWheel::COLOR_HSL;
+      for (int h = 0; h < disk_hue_steps; h++)
+      {
+        for (int s = 0; s < row; s++)
+        {
+          float hf = float(h) / disk_hue_steps;
+          float sf = float(s) / disk_sat_steps;
+          QRgb& out = disk.colors[h * row + s];
+          if (hsl)
+          {
+            detail::rgb_f rgb = detail::rgb_from_hsl(hf, sf, float(val));
+            out = ColorF::fromRgbF(rgb.r, rgb.g, rgb.b).rgba();
+          }
+          else
+          {
+            out = ColorF::fromHsvF(hf, sf, float(val)).rgba();
+          }
+        }
+      }
+    }
+
+    disk.val = val;
+    disk.color_flags = display_flags & ColorWheel::COLOR_FLAGS;
+    disk.gamut_mapping = gamut_mapping;
+  }
+
+  /**
+   * \brief renders the selector as a hue/saturation disk
+   *
+   * The polar map is only computed when the size changes and the color table
+   * when the value or the color space change, hue changes don't affect it.
+   */
+  void render_disk()
+  {
+    int size = qMin<int>(disk_size(), max_size);
+    bool stale = inner_selector.cacheKey() != disk.image_key || inner_selector.width() != size
+                 || disk.gamut_overlay != gamut_overlay;
+
+    if (disk_map.size != size)
+    {
+      disk_map.resize(size);
+      stale = true;
+    }
+
+    if (disk.val != val || disk.color_flags != (display_flags & ColorWheel::COLOR_FLAGS)
+        || disk.gamut_mapping != gamut_mapping)
+    {
+      render_disk_table();
+      stale = true;
+    }
+
+    if (!stale)
+      return;
+
+    inner_selector = QImage(size, size, QImage::Format_RGB32);
+    const int row = disk_sat_steps + 1;
+    bool overlay = gamut_overlay && (display_flags & ColorWheel::COLOR_LCH);
+    for (int y = 0; y < size; y++)
+    {
+      QRgb* line = reinterpret_cast<QRgb*>(inner_selector.scanLine(y));
+      const quint16* hues = &disk_map.hue[y * size];
+      const quint8* sats = &disk_map.sat[y * size];
+      for (int x = 0; x < size; x++)
+      {
+        int index = hues[x] * row + sats[x];
+        line[x] = disk.colors[index];
+        if (overlay && disk.out_of_gamut[index])
+          line[x] = detail::out_of_gamut_marker(line[x], x, y);
+      }
+    }
+    disk.gamut_overlay = gamut_overlay;
+    disk.image_key = inner_selector.cacheKey();
+  }
+
+  /// Function converting LCH components to a color
+  auto lch_color_from() const -> decltype(color_from)
+  {
+    return gamut_mapping ? &detail::color_from_lch_mapped : &detail::color_from_lch;
+  }
+
   /// Updates the inner image that displays the saturation-value selector
   void render_inner_selector()
   {
     if (display_flags & ColorWheel::SHAPE_TRIANGLE)
       render_triangle();
+    else if (display_flags & ColorWheel::SHAPE_DISK)
+      render_disk();
     else
       render_square();
   }
@@ -160,6 +501,8 @@ public:
   {
     if (display_flags & SHAPE_TRIANGLE)
       return QPointF(-inner_radius(), -triangle_side() / 2);
+    if (display_flags & SHAPE_DISK)
+      return QPointF(-inner_radius(), -inner_radius());
     return QPointF(-square_size() / 2, -square_size() / 2);
   }
 
@@ -170,6 +513,8 @@ public:
   {
     if (display_flags & SHAPE_TRIANGLE)
       return QSizeF(triangle_height(), triangle_side());
+    if (display_flags & SHAPE_DISK)
+      return QSizeF(disk_size(), disk_size());
     return QSizeF(square_size(), square_size());
   }
 
@@ -182,6 +527,11 @@ public:
         return -hue * 360 - 60;
       return -150;
     }
+    else if (display_flags & SHAPE_DISK)
+    {
+      // Hues are positions on the disk, it can't rotate
+      return 0;
+    }
     else
     {
       if (display_flags & ANGLE_ROTATING)
@@ -194,7 +544,8 @@ public:
   /// Updates the outer ring that displays the hue selector
   void render_ring()
   {
-    hue_ring = QPixmap(outer_radius() * 2, outer_radius() * 2);
+    hue_ring = QImage(
+        outer_radius() * 2, outer_radius() * 2, QImage::Format_ARGB32_Premultiplied);
     hue_ring.fill(Qt::transparent);
     QPainter painter(&hue_ring);
     painter.setRenderHint(QPainter::Antialiasing);
@@ -221,27 +572,135 @@ public:
     painter.drawEllipse(QPointF(0, 0), inner_radius(), inner_radius());
   }
 
-  void set_color(const QColor& c)
+  /// Components of \p c in the color space of the wheel
+  void wheel_components(const ColorF& c, qreal& h, qreal& s, qreal& v) const
   {
+    detail::rgb_f rgb{c.r, c.g, c.b};
+    h = c.h;
     if (display_flags & ColorWheel::COLOR_HSV)
     {
-      hue = qMax(0.0, c.hsvHueF());
-      sat = c.hsvSaturationF();
-      val = c.valueF();
+      s = c.s;
+      v = c.v;
     }
     else if (display_flags & ColorWheel::COLOR_HSL)
     {
-      hue = qMax(0.0, c.hueF());
-      sat = detail::color_HSL_saturationF(c);
-      val = detail::color_lightnessF(c);
+      s = detail::color_hsl_saturation(rgb);
+      v = detail::color_lightness(rgb);
     }
     else if (display_flags & ColorWheel::COLOR_LCH)
     {
-      hue = qMax(0.0, c.hsvHueF());
-      sat = detail::color_chromaF(c);
-      val = detail::color_lumaF(c);
+      s = detail::color_chroma(rgb);
+      v = detail::color_luma(rgb);
     }
   }
+
+  void set_color(const ColorF& c) { wheel_components(c, hue, sat, val); }
+
+  /// Whether \p c has the same RGB components as the current color
+  bool same_color(const ColorF& c) const
+  {
+    ColorF current = color();
+    return detail::fuzzy_same(c.r, current.r) && detail::fuzzy_same(c.g, current.g)
+           && detail::fuzzy_same(c.b, current.b);
+  }
+
+  /// Color from components in the color space of the wheel
+  ColorF color_at(qreal h, qreal s, qreal v) const
+  {
+    detail::rgb_f rgb;
+    if (display_flags & ColorWheel::COLOR_HSL)
+      rgb = detail::rgb_from_hsl(h, s, v);
+    else if (display_flags & ColorWheel::COLOR_LCH)
+      rgb = gamut_mapping ? detail::rgb_from_lch_mapped(h, s, v) : detail::rgb_from_lch(h, s, v);
+    else
+      return ColorF::fromHsvF(h, s, v);
+    return ColorF::fromRgbF(rgb.r, rgb.g, rgb.b, 1, h);
+  }
+
+  /// Current color, computed without going through QColor
+  ColorF color() const { return color_at(hue, sat, val); }
+
+  /// Reads the markers from the palette
+  void load_markers()
+  {
+    markers.clear();
+    if (palette)
+    {
+      int count = palette->count();
+      markers.resize(count);
+      for (int i = 0; i < count; i++)
+      {
+        palette_marker& marker = markers[i];
+        marker.color = palette->colorAt(i);
+        wheel_components(ColorF::fromColor(marker.color), marker.hue, marker.sat, marker.val);
+      }
+    }
+    // Indices and start hues of a marker drag no longer match the markers
+    if (mouse_status == DragMarker)
+      mouse_status = Nothing;
+    drag_marker = -1;
+    drag_start_hues.clear();
+    // The markers match the palette, a pending push would only repeat its colors
+    push_timer.stop();
+    layout_markers();
+  }
+
+  /// Updates marker positions and the hit test grid
+  void layout_markers()
+  {
+    qreal radius = inner_radius();
+    for (auto& marker : markers)
+    {
+      QLineF ray(0, 0, qMin<qreal>(marker.sat, 1) * radius, 0);
+      ray.setAngle(marker.hue * 360);
+      marker.pos = ray.p2();
+    }
+    grid.build(markers, radius + marker_radius, marker_radius * 2);
+  }
+
+  /// Updates the color of an edited marker
+  void update_marker_color(palette_marker& marker)
+  {
+    QColor color = color_at(marker.hue, marker.sat, marker.val).toColor();
+    color.setAlpha(marker.color.alpha());
+    marker.color = color;
+  }
+
+  /// Writes all the marker colors to the palette as a single change
+  void push_markers()
+  {
+    push_timer.stop();
+    if (!palette)
+      return;
+
+    QVector<QPair<QColor, QString>> colors = palette->colors();
+    int count = qMin(colors.size(), int(markers.size()));
+    for (int i = 0; i < count; i++)
+      colors[i].first = markers[i].color;
+
+    pushing = true;
+    palette->setColors(colors);
+    pushing = false;
+  }
+
+  /// Pushes the markers to the palette with the next frame
+  void schedule_push()
+  {
+    if (!push_timer.isActive())
+      push_timer.start();
+  }
+
+  /// Rotates the hue of all markers by \p delta turns from \p start_hues
+  void rotate_markers(const std::vector<qreal>& start_hues, qreal delta)
+  {
+    int count = int(qMin(markers.size(), start_hues.size()));
+    for (int i = 0; i < count; i++)
+    {
+      markers[i].hue = std::fmod(start_hues[i] + delta + 2, 1.0);
+      update_marker_color(markers[i]);
+    }
+    layout_markers();
+  }
 };
 
 ColorWheel::ColorWheel(QWidget* parent) : QWidget(parent), p(new Private(this))
@@ -252,6 +711,8 @@ ColorWheel::ColorWheel(QWidget* parent) : QWidget(parent), p(new Private(this))
 
 ColorWheel::~ColorWheel()
 {
+  if (p->push_timer.isActive())
+    p->push_markers();
   delete p;
 }
 
@@ -260,6 +721,11 @@ QColor ColorWheel::color() const
   return p->color_from(p->hue, p->sat, p->val, 1);
 }
 
+ColorF ColorWheel::colorF() const
+{
+  return p->color();
+}
+
 QSize ColorWheel::sizeHint() const
 {
   return QSize(p->wheel_width * 5, p->wheel_width * 5);
@@ -268,18 +734,18 @@ QSize ColorWheel::sizeHint() const
 qreal ColorWheel::hue() const
 {
   if ((p->display_flags & COLOR_LCH) && p->sat > 0.01)
-    return color().hueF();
+    return p->color().h;
   return p->hue;
 }
 
 qreal ColorWheel::saturation() const
 {
-  return color().hsvSaturationF();
+  return p->color().s;
 }
 
 qreal ColorWheel::value() const
 {
-  return color().valueF();
+  return p->color().v;
 }
 
 unsigned int ColorWheel::wheelWidth() const
@@ -291,6 +757,7 @@ void ColorWheel::setWheelWidth(unsigned int w)
 {
   p->wheel_width = w;
   p->render_inner_selector();
+  p->layout_markers();
   update();
 }
 
@@ -304,7 +771,8 @@ void ColorWheel::paintEvent(QPaintEvent*)
   if (p->hue_ring.isNull())
     p->render_ring();
 
-  painter.drawPixmap(-p->outer_radius(), -p->outer_radius(), p->hue_ring);
+  painter.drawImage(
+      QPointF(-p->outer_radius(), -p->outer_radius()), p->simulated_ring(p->hue_ring));
 
   // hue selector
   painter.setPen(QPen(Qt::black, 3));
@@ -345,8 +813,19 @@ void ColorWheel::paintEvent(QPaintEvent*)
     clip.addPolygon(triangle);
     painter.setClipPath(clip);
   }
+  else if (p->display_flags & SHAPE_DISK)
+  {
+    qreal radius = p->inner_radius();
+    QLineF selector_ray(radius, radius, radius + p->sat * radius, radius);
+    selector_ray.setAngle(p->hue * 360);
+    selector_position = selector_ray.p2();
+    QPainterPath clip;
+    clip.addEllipse(QPointF(radius, radius), radius, radius);
+    painter.setClipPath(clip);
+  }
 
-  painter.drawImage(QRectF(QPointF(0, 0), p->selector_size()), p->inner_selector);
+  painter.drawImage(
+      QRectF(QPointF(0, 0), p->selector_size()), p->simulated_selector(p->inner_selector));
   painter.setClipping(false);
 
   // lum-sat selector
@@ -356,10 +835,50 @@ void ColorWheel::paintEvent(QPaintEvent*)
       selector_position,
       color_widgets::detail::selector_radius,
       color_widgets::detail::selector_radius);
+
+  // palette markers, drawn over the cached images without changing them
+  if (!p->markers.empty())
+  {
+    painter.resetTransform();
+    painter.translate(geometry().width() / 2, geometry().height() / 2);
+    for (int i = 0; i < int(p->markers.size()); i++)
+    {
+      const palette_marker& marker = p->markers[i];
+      painter.setPen(QPen(i == p->drag_marker ? Qt::white : Qt::black, 1.5));
+      painter.setBrush(marker.color);
+      painter.drawEllipse(marker.pos, marker_radius, marker_radius);
+    }
+  }
 }
 
 void ColorWheel::mouseMoveEvent(QMouseEvent* ev)
 {
+  if (p->mouse_status == DragMarker)
+  {
+    QLineF ray = p->line_to_point(ev->pos());
+    // Clicks don't change the markers
+    if (!p->drag_moved && ev->pos() == p->drag_start_pos)
+      return;
+
+    if (p->drag_rotates)
+    {
+      p->rotate_markers(p->drag_start_hues, (ray.angle() - p->drag_start_angle) / 360);
+    }
+    else if (p->drag_marker >= 0 && p->drag_marker < int(p->markers.size()))
+    {
+      palette_marker& marker = p->markers[p->drag_marker];
+      QLineF target(QPointF(0, 0), ray.p2() - ray.p1() + p->drag_offset);
+      marker.hue = target.angle() / 360;
+      marker.sat = qBound(0.0, target.length() / p->inner_radius(), 1.0);
+      p->update_marker_color(marker);
+      p->layout_markers();
+    }
+    p->drag_moved = true;
+    p->schedule_push();
+    update();
+    return;
+  }
+
   if (p->mouse_status == DragCircle)
   {
     p->hue = p->line_to_point(ev->pos()).angle() / 360.0;
@@ -382,6 +901,12 @@ void ColorWheel::mouseMoveEvent(QMouseEvent* ev)
       p->sat = qBound(0.0, center_mouse_ln.x2() / p->square_size(), 1.0);
       p->val = qBound(0.0, center_mouse_ln.y2() / p->square_size(), 1.0);
     }
+    else if (p->display_flags & SHAPE_DISK)
+    {
+      // Polar coordinates, as in the polar map of the disk
+      p->hue = glob_mouse_ln.angle() / 360.0;
+      p->sat = qBound(0.0, glob_mouse_ln.length() / p->inner_radius(), 1.0);
+    }
     else if (p->display_flags & SHAPE_TRIANGLE)
     {
       QPointF pt = center_mouse_ln.p2();
@@ -409,6 +934,24 @@ void ColorWheel::mousePressEvent(QMouseEvent* ev)
   {
     setFocus();
     QLineF ray = p->line_to_point(ev->pos());
+
+    int marker = p->grid.find(p->markers, ray.p2() - ray.p1(), marker_radius);
+    if (marker != -1)
+    {
+      p->mouse_status = DragMarker;
+      p->drag_marker = marker;
+      p->drag_rotates = ev->modifiers() & Qt::ShiftModifier;
+      p->drag_start_angle = ray.angle();
+      p->drag_start_pos = ev->pos();
+      p->drag_offset = p->markers[marker].pos - (ray.p2() - ray.p1());
+      p->drag_moved = false;
+      p->drag_start_hues.clear();
+      for (const auto& m : p->markers)
+        p->drag_start_hues.push_back(m.hue);
+      update();
+      return;
+    }
+
     if (ray.length() <= p->inner_radius())
       p->mouse_status = DragSquare;
     else if (ray.length() <= p->outer_radius())
@@ -421,7 +964,18 @@ void ColorWheel::mousePressEvent(QMouseEvent* ev)
 
 void ColorWheel::mouseReleaseEvent(QMouseEvent* ev)
 {
-  mouseMoveEvent(ev);
+  if (p->mouse_status == DragMarker)
+  {
+    // The last move event already placed the markers
+    if (p->drag_moved)
+      p->push_markers();
+    p->drag_marker = -1;
+    update();
+  }
+  else
+  {
+    mouseMoveEvent(ev);
+  }
   p->mouse_status = Nothing;
 }
 
@@ -429,34 +983,71 @@ void ColorWheel::resizeEvent(QResizeEvent*)
 {
   p->render_ring();
   p->render_inner_selector();
+  p->layout_markers();
 }
 
 void ColorWheel::setColor(QColor c)
 {
+  detail::update_guard guard(p->updating);
+  if (!guard.enter(!p->same_color(ColorF::fromColor(c))))
+    return;
+
   qreal oldh = p->hue;
-  p->set_color(c);
-  if (!qFuzzyCompare(oldh + 1, p->hue + 1))
+  p->set_color(ColorF::fromColor(c));
+  // The disk only depends on the value and skips rendering if it didn't change
+  if (!qFuzzyCompare(oldh + 1, p->hue + 1) || (p->display_flags & SHAPE_DISK))
     p->render_inner_selector();
   update();
   colorChanged(c);
 }
 
+void ColorWheel::setColorF(const ColorF& c)
+{
+  detail::update_guard guard(p->updating);
+  if (!guard.enter(!p->same_color(c)))
+    return;
+
+  qreal oldh = p->hue;
+  p->set_color(c);
+  if (!qFuzzyCompare(oldh + 1, p->hue + 1) || (p->display_flags & SHAPE_DISK))
+    p->render_inner_selector();
+  update();
+  colorChanged(c.toColor());
+}
+
 void ColorWheel::setHue(qreal h)
 {
-  p->hue = qBound(0.0, h, 1.0);
+  h = qBound(0.0, h, 1.0);
+  detail::update_guard guard(p->updating);
+  if (!guard.enter(!detail::fuzzy_same(h, p->hue)))
+    return;
+
+  p->hue = h;
   p->render_inner_selector();
   update();
 }
 
 void ColorWheel::setSaturation(qreal s)
 {
-  p->sat = qBound(0.0, s, 1.0);
+  s = qBound(0.0, s, 1.0);
+  detail::update_guard guard(p->updating);
+  if (!guard.enter(!detail::fuzzy_same(s, p->sat)))
+    return;
+
+  p->sat = s;
   update();
 }
 
 void ColorWheel::setValue(qreal v)
 {
-  p->val = qBound(0.0, v, 1.0);
+  v = qBound(0.0, v, 1.0);
+  detail::update_guard guard(p->updating);
+  if (!guard.enter(!detail::fuzzy_same(v, p->val)))
+    return;
+
+  p->val = v;
+  if (p->display_flags & SHAPE_DISK)
+    p->render_inner_selector();
   update();
 }
 
@@ -471,40 +1062,139 @@ void ColorWheel::setDisplayFlags(DisplayFlags flags)
 
   if ((flags & COLOR_FLAGS) != (p->display_flags & COLOR_FLAGS))
   {
-    QColor old_col = color();
+    ColorF old_col = p->color();
+    detail::rgb_f old_rgb{old_col.r, old_col.g, old_col.b};
+    p->hue = old_col.h;
     if (flags & ColorWheel::COLOR_HSL)
     {
-      p->hue = old_col.hueF();
-      p->sat = detail::color_HSL_saturationF(old_col);
-      p->val = detail::color_lightnessF(old_col);
+      p->sat = detail::color_hsl_saturation(old_rgb);
+      p->val = detail::color_lightness(old_rgb);
       p->color_from = &detail::color_from_hsl;
       p->rainbow_from_hue = &detail::rainbow_hsv;
     }
     else if (flags & ColorWheel::COLOR_LCH)
     {
-      p->hue = old_col.hueF();
-      p->sat = detail::color_chromaF(old_col);
-      p->val = detail::color_lumaF(old_col);
-      p->color_from = &detail::color_from_lch;
+      p->sat = detail::color_chroma(old_rgb);
+      p->val = detail::color_luma(old_rgb);
+      p->color_from = p->lch_color_from();
       p->rainbow_from_hue = &detail::rainbow_lch;
     }
     else
     {
-      p->hue = old_col.hsvHueF();
-      p->sat = old_col.hsvSaturationF();
-      p->val = old_col.valueF();
+      p->sat = old_col.s;
+      p->val = old_col.v;
       p->color_from = &QColor::fromHsvF;
       p->rainbow_from_hue = &detail::rainbow_hsv;
     }
     p->render_ring();
   }
 
+  bool color_space_changed = (flags & COLOR_FLAGS) != (p->display_flags & COLOR_FLAGS);
   p->display_flags = flags;
+  if (color_space_changed)
+  {
+    if (p->push_timer.isActive())
+      p->push_markers();
+    p->load_markers();
+  }
   p->render_inner_selector();
   update();
   displayFlagsChanged(flags);
 }
 
+bool ColorWheel::gamutMapping() const
+{
+  return p->gamut_mapping;
+}
+
+void ColorWheel::setGamutMapping(bool gamutMapping)
+{
+  if (gamutMapping == p->gamut_mapping)
+    return;
+
+  p->gamut_mapping = gamutMapping;
+  gamutMappingChanged(gamutMapping);
+  if (p->display_flags & COLOR_LCH)
+  {
+    p->color_from = p->lch_color_from();
+    p->render_inner_selector();
+    update();
+    colorChanged(color());
+  }
+}
+
+bool ColorWheel::gamutOverlay() const
+{
+  return p->gamut_overlay;
+}
+
+void ColorWheel::setGamutOverlay(bool gamutOverlay)
+{
+  if (gamutOverlay == p->gamut_overlay)
+    return;
+
+  p->gamut_overlay = gamutOverlay;
+  gamutOverlayChanged(gamutOverlay);
+  if (p->display_flags & COLOR_LCH)
+  {
+    p->render_inner_selector();
+    update();
+  }
+}
+
+ColorPalette* ColorWheel::markerPalette() const
+{
+  return p->palette;
+}
+
+void ColorWheel::setMarkerPalette(ColorPalette* palette)
+{
+  if (palette == p->palette)
+    return;
+
+  if (p->palette)
+  {
+    p->push_markers();
+    disconnect(p->palette, nullptr, this, nullptr);
+  }
+
+  p->palette = palette;
+
+  if (palette)
+  {
+    auto reload = [this] {
+      if (!p->pushing)
+      {
+        p->load_markers();
+        update();
+      }
+    };
+    connect(palette, &ColorPalette::colorsChanged, this, reload);
+    connect(palette, &ColorPalette::colorsUpdated, this, reload);
+    connect(palette, &ColorPalette::colorChanged, this, reload);
+    connect(palette, &ColorPalette::colorAdded, this, reload);
+    connect(palette, &ColorPalette::colorRemoved, this, reload);
+    connect(palette, &QObject::destroyed, this, reload);
+  }
+
+  p->load_markers();
+  update();
+  markerPaletteChanged(palette);
+}
+
+void ColorWheel::rotateMarkers(qreal delta)
+{
+  if (p->markers.empty())
+    return;
+
+  std::vector<qreal> hues;
+  for (const auto& marker : p->markers)
+    hues.push_back(marker.hue);
+  p->rotate_markers(hues, delta);
+  p->push_markers();
+  update();
+}
+
 ColorWheel::DisplayFlags ColorWheel::displayFlags(DisplayFlags mask) const
 {
   return p->display_flags & mask;
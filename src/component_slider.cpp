@@ -0,0 +1,314 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "component_slider.hpp"
+
+#include "gamut_mapping.hpp"
+#include "update_guard.hpp"
+
+#include <QPainter>
+
+#include <vector>
+
+#include <wobjectimpl.h>
+W_OBJECT_IMPL(color_widgets::ComponentSlider)
+namespace color_widgets
+{
+
+/**
+ * \brief Fills \p out with \p count opaque colors, changing the coordinate
+ * \p channel of \p coords from 0 to 1
+ */
+using strip_kernel = void (*)(const float* coords, int channel, int count, QRgb* out);
+
+static quint8 to_8bit(float value)
+{
+  return quint8(detail::math::clamp(value, 0.f, 1.f) * 255 + 0.5f);
+}
+
+static detail::rgb_f rgb_from_rgb(float r, float g, float b)
+{
+  return {r, g, b};
+}
+
+static detail::rgb_f rgb_from_hsv(float h, float s, float v)
+{
+  ColorF c = ColorF::fromHsvF(h, s, v);
+  return {c.r, c.g, c.b};
+}
+
+template<detail::rgb_f (*Convert)(float, float, float)>
+static void render_strip(const float* coords, int channel, int count, QRgb* out)
+{
+  float c[3] = {coords[0], coords[1], coords[2]};
+  float step = count > 1 ? 1.f / (count - 1) : 0;
+  for (int i = 0; i < count; i++)
+  {
+    c[channel] = i * step;
+    detail::rgb_f rgb = Convert(c[0], c[1], c[2]);
+    out[i] = qRgb(to_8bit(rgb.r), to_8bit(rgb.g), to_8bit(rgb.b));
+  }
+}
+
+static void render_strip_lch(const float* coords, int channel, int count, QRgb* out)
+{
+  std::vector<float> values(count * 3);
+  float* c[3] = {values.data(), values.data() + count, values.data() + count * 2};
+  float step = count > 1 ? 1.f / (count - 1) : 0;
+  for (int component = 0; component < 3; component++)
+  {
+    for (int i = 0; i < count; i++)
+      c[component][i] = component == channel ? i * step : coords[component];
+  }
+  detail::lch_to_rgb(c[0], c[1], c[2], count, out, nullptr, false);
+}
+
+/// Indexed by ComponentSlider::Model
+static const strip_kernel strip_kernels[] = {
+    render_strip<rgb_from_rgb>,
+    render_strip<rgb_from_hsv>,
+    render_strip<detail::rgb_from_hsl>,
+    render_strip_lch,
+};
+
+class ComponentSlider::Private
+{
+public:
+  ComponentSlider* w;
+  Model model = Hsv;
+  Component component = Hue;
+  ColorF context = ColorF::fromHsvF(0, 1, 1);
+  QImage strip;
+  bool strip_dirty = true;
+  bool updating = false;
+
+  Private(ComponentSlider* widget) : w(widget) { }
+
+  /// Index of the selected component in coords()
+  int channel() const { return component >= Red ? component - Red : int(component); }
+
+  /// Components of \p color in the current model, followed by alpha
+  void coords(const ColorF& color, float* out) const
+  {
+    detail::rgb_f rgb{color.r, color.g, color.b};
+    switch (model)
+    {
+      case Rgb:
+        out[0] = color.r;
+        out[1] = color.g;
+        out[2] = color.b;
+        break;
+      case Hsv:
+        out[0] = color.h;
+        out[1] = color.s;
+        out[2] = color.v;
+        break;
+      case Hsl:
+        out[0] = color.h;
+        out[1] = detail::color_hsl_saturation(rgb);
+        out[2] = detail::color_lightness(rgb);
+        break;
+      case Lch:
+        out[0] = color.h;
+        out[1] = detail::color_chroma(rgb);
+        out[2] = detail::color_luma(rgb);
+        break;
+    }
+    out[3] = color.a;
+  }
+
+  /// Inverse of coords(), grays take their hue from the context
+  ColorF from_coords(const float* c) const
+  {
+    detail::rgb_f rgb;
+    switch (model)
+    {
+      case Rgb:
+        return ColorF::fromRgbF(c[0], c[1], c[2], c[3], context.h);
+      case Hsv:
+        return ColorF::fromHsvF(c[0], c[1], c[2], c[3]);
+      case Hsl:
+        rgb = detail::rgb_from_hsl(c[0], c[1], c[2]);
+        return ColorF::fromRgbF(rgb.r, rgb.g, rgb.b, c[3], c[0]);
+      case Lch:
+      default:
+        rgb = detail::rgb_from_lch(c[0], c[1], c[2]);
+        return ColorF::fromRgbF(rgb.r, rgb.g, rgb.b, c[3], c[0]);
+    }
+  }
+
+  qreal position() const
+  {
+    if (w->maximum() == w->minimum())
+      return 0;
+    return qreal(w->value() - w->minimum()) / (w->maximum() - w->minimum());
+  }
+
+  void set_position(qreal pos)
+  {
+    w->setValue(w->minimum() + qRound(pos * (w->maximum() - w->minimum())));
+  }
+
+  void invalidate()
+  {
+    strip_dirty = true;
+    w->update();
+  }
+
+  /**
+   * \brief Renders the gradient into \p strip, unless it's up to date
+   * \param length Length of the strip in logical pixels
+   * \param ratio  Device pixel ratio, one color is rendered per device pixel
+   */
+  void render_strip(int length, qreal ratio)
+  {
+    length = qRound(length * ratio);
+    bool horizontal = w->orientation() == Qt::Horizontal;
+    QSize size = horizontal ? QSize(length, 1) : QSize(1, length);
+    if (!strip_dirty && strip.size() == size && strip.devicePixelRatio() == ratio)
+      return;
+
+    strip_dirty = false;
+    strip = QImage(size, QImage::Format_ARGB32);
+    strip.setDevicePixelRatio(ratio);
+    if (length <= 0)
+      return;
+
+    float c[4];
+    coords(context, c);
+    QRgb* out = reinterpret_cast<QRgb*>(strip.bits());
+
+    if (component == Alpha)
+    {
+      // Only alpha changes, the color is converted once
+      QRgb rgb = from_coords(c).rgba();
+      for (int i = 0; i < length; i++)
+        out[i] = qRgba(qRed(rgb), qGreen(rgb), qBlue(rgb), length > 1 ? i * 255 / (length - 1) : 0);
+    }
+    else
+    {
+      strip_kernels[model](c, channel(), length, out);
+    }
+  }
+};
+
+ComponentSlider::ComponentSlider(QWidget* parent) : GradientSlider(parent), p(new Private(this))
+{
+}
+
+ComponentSlider::ComponentSlider(Qt::Orientation orientation, QWidget* parent)
+    : GradientSlider(orientation, parent), p(new Private(this))
+{
+}
+
+ComponentSlider::~ComponentSlider()
+{
+  delete p;
+}
+
+ComponentSlider::Model ComponentSlider::model() const
+{
+  return p->model;
+}
+
+void ComponentSlider::setModel(Model model)
+{
+  if (model != p->model)
+  {
+    p->model = model;
+    p->invalidate();
+  }
+}
+
+ComponentSlider::Component ComponentSlider::component() const
+{
+  return p->component;
+}
+
+void ComponentSlider::setComponent(Component component)
+{
+  if (component != p->component)
+  {
+    p->component = component;
+    p->invalidate();
+  }
+}
+
+QColor ComponentSlider::color() const
+{
+  return colorF().toColor();
+}
+
+ColorF ComponentSlider::colorF() const
+{
+  float c[4];
+  p->coords(p->context, c);
+  c[p->component == Alpha ? 3 : p->channel()] = p->position();
+  return p->from_coords(c);
+}
+
+void ComponentSlider::setColorF(const ColorF& color)
+{
+  setContext(color);
+
+  float c[4];
+  p->coords(color, c);
+  p->set_position(c[p->component == Alpha ? 3 : p->channel()]);
+}
+
+ColorF ComponentSlider::context() const
+{
+  return p->context;
+}
+
+void ComponentSlider::setContext(const ColorF& color)
+{
+  detail::update_guard guard(p->updating);
+  bool changed = !detail::fuzzy_same(color.r, p->context.r)
+                 || !detail::fuzzy_same(color.g, p->context.g)
+                 || !detail::fuzzy_same(color.b, p->context.b)
+                 || !detail::fuzzy_same(color.a, p->context.a)
+                 || !detail::fuzzy_same(color.h, p->context.h);
+  if (!guard.enter(changed))
+    return;
+
+  p->context = color;
+  p->invalidate();
+}
+
+void ComponentSlider::setColor(const QColor& color)
+{
+  ColorF c = ColorF::fromColor(color);
+  if (c.s == 0)
+    c.h = p->context.h;
+  setColorF(c);
+}
+
+void ComponentSlider::paintGradient(QPainter& painter, const QRect& rect)
+{
+  p->render_strip(
+      orientation() == Qt::Horizontal ? rect.width() : rect.height(), devicePixelRatioF());
+  painter.drawImage(rect, p->strip);
+  painter.setBrush(Qt::NoBrush);
+  painter.drawRect(rect);
+}
+
+} // namespace color_widgets
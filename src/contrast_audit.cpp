@@ -0,0 +1,240 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "contrast_audit.hpp"
+
+#include "color_utils.hpp"
+#include "parallel.hpp"
+
+namespace color_widgets
+{
+
+static float contrast(float luminance_a, float luminance_b)
+{
+  return (qMax(luminance_a, luminance_b) + 0.05f) / (qMin(luminance_a, luminance_b) + 0.05f);
+}
+
+class ContrastAudit::Private
+{
+public:
+  QVector<QRgb> colors;
+  QVector<float> luminance;
+  QVector<float> matrix;
+  Summary summary;
+  int threads = 0;
+
+  /**
+   * \brief Fills the contrast matrix in square blocks
+   *
+   * Each block of the upper triangle is written along with its mirror in the
+   * lower one, blocks are small enough for both to stay in cache.
+   */
+  void audit()
+  {
+    int count = colors.size();
+    luminance.resize(count);
+    for (int i = 0; i < count; i++)
+      luminance[i] = ContrastAudit::luminance(colors[i]);
+
+    matrix.resize(count * count);
+    summary = Summary();
+    summary.pairs = count * (count - 1) / 2;
+    if (count == 0)
+      return;
+
+    const int block = 64;
+    int blocks = (count + block - 1) / block;
+    int block_pairs = blocks * (blocks + 1) / 2;
+    int workers = detail::thread_count(threads, block_pairs);
+    QVector<Summary> partial(workers);
+
+    const float* lum = luminance.constData();
+    float* out = matrix.data();
+    const float aa_large = threshold(AALarge), aa = threshold(AA), aaa = threshold(AAA);
+
+    detail::run_threads(workers, [&](int thread) {
+      Summary local;
+      int pair = 0;
+      for (int block_row = 0; block_row < count; block_row += block)
+      {
+        for (int block_col = block_row; block_col < count; block_col += block, pair++)
+        {
+          if (pair % workers != thread)
+            continue;
+
+          int row_end = qMin(count, block_row + block);
+          int col_end = qMin(count, block_col + block);
+          for (int row = block_row; row < row_end; row++)
+          {
+            float* row_data = out + qptrdiff(row) * count;
+            if (block_row == block_col)
+              row_data[row] = 1;
+            for (int col = qMax(block_col, row + 1); col < col_end; col++)
+            {
+              float ratio = contrast(lum[row], lum[col]);
+              row_data[col] = ratio;
+              out[qptrdiff(col) * count + row] = ratio;
+              local.aa_large += ratio >= aa_large;
+              local.aa += ratio >= aa;
+              local.aaa += ratio >= aaa;
+            }
+          }
+        }
+      }
+      partial[thread] = local;
+    });
+
+    for (const Summary& part : partial)
+    {
+      summary.aa_large += part.aa_large;
+      summary.aa += part.aa;
+      summary.aaa += part.aaa;
+    }
+  }
+};
+
+ContrastAudit::ContrastAudit(const ColorPalette& palette) : p(new Private)
+{
+  setPalette(palette);
+}
+
+ContrastAudit::ContrastAudit(const ContrastAudit& other) : p(new Private(*other.p)) { }
+
+ContrastAudit& ContrastAudit::operator=(const ContrastAudit& other)
+{
+  *p = *other.p;
+  return *this;
+}
+
+ContrastAudit::~ContrastAudit()
+{
+  delete p;
+}
+
+int ContrastAudit::threadCount() const
+{
+  return p->threads;
+}
+
+void ContrastAudit::setThreadCount(int threads)
+{
+  p->threads = qMax(0, threads);
+}
+
+void ContrastAudit::setPalette(const ColorPalette& palette)
+{
+  setColorTable(palette.colorTable());
+}
+
+void ContrastAudit::setColorTable(const QVector<QRgb>& colors)
+{
+  p->colors = colors;
+  p->audit();
+}
+
+QVector<QRgb> ContrastAudit::colorTable() const
+{
+  return p->colors;
+}
+
+QVector<float> ContrastAudit::matrix() const
+{
+  return p->matrix;
+}
+
+float ContrastAudit::ratio(int a, int b) const
+{
+  int count = p->colors.size();
+  if (a < 0 || b < 0 || a >= count || b >= count)
+    return 1;
+  return p->matrix[a * count + b];
+}
+
+ContrastAudit::Summary ContrastAudit::summary() const
+{
+  return p->summary;
+}
+
+QVector<QPair<int, int>> ContrastAudit::failingPairs(Level required) const
+{
+  QVector<QPair<int, int>> pairs;
+  float min_ratio = threshold(required);
+  int count = p->colors.size();
+  for (int row = 0; row < count; row++)
+  {
+    const float* row_data = p->matrix.constData() + qptrdiff(row) * count;
+    for (int col = row + 1; col < count; col++)
+      if (row_data[col] < min_ratio)
+        pairs.push_back(qMakePair(row, col));
+  }
+  return pairs;
+}
+
+QVector<float> ContrastAudit::against(const QColor& background) const
+{
+  float background_luminance = luminance(background.rgb());
+  QVector<float> ratios;
+  ratios.reserve(p->luminance.size());
+  for (float color_luminance : p->luminance)
+    ratios.push_back(contrast(color_luminance, background_luminance));
+  return ratios;
+}
+
+float ContrastAudit::luminance(QRgb color)
+{
+  return 0.2126f * detail::srgb_to_linear(qRed(color))
+         + 0.7152f * detail::srgb_to_linear(qGreen(color))
+         + 0.0722f * detail::srgb_to_linear(qBlue(color));
+}
+
+float ContrastAudit::contrastRatio(QRgb a, QRgb b)
+{
+  return contrast(luminance(a), luminance(b));
+}
+
+float ContrastAudit::threshold(Level level)
+{
+  switch (level)
+  {
+    case Fail:
+      return 1;
+    case AALarge:
+      return 3;
+    case AA:
+      return 4.5f;
+    case AAA:
+      return 7;
+  }
+  return 1;
+}
+
+ContrastAudit::Level ContrastAudit::level(float ratio)
+{
+  if (ratio >= threshold(AAA))
+    return AAA;
+  if (ratio >= threshold(AA))
+    return AA;
+  if (ratio >= threshold(AALarge))
+    return AALarge;
+  return Fail;
+}
+
+} // namespace color_widgets
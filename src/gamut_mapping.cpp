@@ -0,0 +1,244 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "gamut_mapping.hpp"
+
+#include "color_utils.hpp"
+
+#include <qmath.h>
+
+#include <cmath>
+#include <cstring>
+
+namespace color_widgets
+{
+namespace detail
+{
+
+static const int chunk = 256;
+
+static int to_8bit(float c)
+{
+  return int(math::clamp(c, 0.f, 1.f) * 255 + 0.5f);
+}
+
+const oklch_chroma_table& oklch_chroma_table::instance()
+{
+  static const oklch_chroma_table table;
+  return table;
+}
+
+oklch_chroma_table::oklch_chroma_table() : values((hue_steps + 1) * (lightness_steps + 1))
+{
+  for (int h = 0; h <= hue_steps; h++)
+  {
+    float angle = 2 * float(M_PI) * h / hue_steps;
+    float a = std::cos(angle), b = std::sin(angle);
+    for (int l = 0; l <= lightness_steps; l++)
+      values[h * (lightness_steps + 1) + l] = oklab_max_chroma(float(l) / lightness_steps, a, b);
+  }
+}
+
+float oklch_chroma_table::max_chroma(float lightness, float hue) const
+{
+  float hf = math::clamp(hue, 0.f, 1.f) * hue_steps;
+  float lf = math::clamp(lightness, 0.f, 1.f) * lightness_steps;
+  int h = math::min(int(hf), hue_steps - 1);
+  int l = math::min(int(lf), lightness_steps - 1);
+  hf -= h;
+  lf -= l;
+
+  const float* row = values.data() + h * (lightness_steps + 1) + l;
+  const float* next = row + lightness_steps + 1;
+  float low = row[0] + (row[1] - row[0]) * lf;
+  float high = next[0] + (next[1] - next[0]) * lf;
+  return low + (high - low) * hf;
+}
+
+void lch_to_rgb(
+    const float* hue,
+    const float* chroma,
+    const float* luma,
+    int count,
+    QRgb* out,
+    quint8* out_of_gamut,
+    bool map)
+{
+  quint8 clipped[chunk];
+  for (int start = 0; start < count; start += chunk)
+  {
+    int size = math::min(chunk, count - start);
+    const float* hues = hue + start;
+    const float* c = chroma + start;
+    const float* y = luma + start;
+    QRgb* rgb = out + start;
+
+    for (int i = 0; i < size; i++)
+    {
+      // Same as rgb_from_hue_chroma(hue, 1), without branches
+      float h = hues[i] * 6;
+      float r = math::clamp(math::abs(h - 3) - 1, 0.f, 1.f);
+      float g = math::clamp(2 - math::abs(h - 2), 0.f, 1.f);
+      float b = math::clamp(2 - math::abs(h - 4), 0.f, 1.f);
+      float unit_luma = 0.30f * r + 0.59f * g + 0.11f * b;
+      float max_chroma = math::min(y[i] / unit_luma, (1 - y[i]) / (1 - unit_luma));
+
+      clipped[i] = c[i] > max_chroma + 1e-4f;
+      float col_chroma = map ? math::min(c[i], max_chroma) : c[i];
+      float offset = y[i] - col_chroma * unit_luma;
+      rgb[i] = qRgb(
+          to_8bit(col_chroma * r + offset),
+          to_8bit(col_chroma * g + offset),
+          to_8bit(col_chroma * b + offset));
+    }
+
+    if (out_of_gamut)
+      std::memcpy(out_of_gamut + start, clipped, size);
+  }
+}
+
+/**
+ * \brief Converts a chunk of OKLCH colors, shared by oklch_to_rgb() and oklab_to_rgb()
+ * \param a, b Unit vector of the hue \p h
+ */
+static void oklch_chunk(
+    const float* l,
+    const float* c,
+    const float* h,
+    const float* a,
+    const float* b,
+    int size,
+    QRgb* out,
+    quint8* clipped,
+    bool map,
+    const oklch_chroma_table* table)
+{
+  float max_chroma[chunk];
+  int ri[chunk], gi[chunk], bi[chunk];
+  const quint8* encode = srgb_encode_table();
+
+  for (int i = 0; i < size; i++)
+    max_chroma[i] = table ? table->max_chroma(l[i], h[i]) : oklab_max_chroma(l[i], a[i], b[i]);
+
+  for (int i = 0; i < size; i++)
+  {
+    // The table is interpolated, only colors actually out of gamut are mapped
+    rgb_f rgb = oklab_to_linear({l[i], a[i] * c[i], b[i] * c[i]});
+    clipped[i] = !in_gamut(rgb);
+    if (clipped[i] && map && c[i] > max_chroma[i])
+      rgb = oklab_to_linear({l[i], a[i] * max_chroma[i], b[i] * max_chroma[i]});
+    ri[i] = int(math::clamp(rgb.r, 0.f, 1.f) * srgb_encode_steps + 0.5f);
+    gi[i] = int(math::clamp(rgb.g, 0.f, 1.f) * srgb_encode_steps + 0.5f);
+    bi[i] = int(math::clamp(rgb.b, 0.f, 1.f) * srgb_encode_steps + 0.5f);
+  }
+
+  for (int i = 0; i < size; i++)
+    out[i] = qRgb(encode[ri[i]], encode[gi[i]], encode[bi[i]]);
+}
+
+void oklch_to_rgb(
+    const float* lightness,
+    const float* chroma,
+    const float* hue,
+    int count,
+    QRgb* out,
+    quint8* out_of_gamut,
+    bool map,
+    const oklch_chroma_table* table)
+{
+  float a[chunk], b[chunk];
+  quint8 clipped[chunk];
+
+  for (int start = 0; start < count; start += chunk)
+  {
+    int size = math::min(chunk, count - start);
+    const float* h = hue + start;
+
+    for (int i = 0; i < size; i++)
+    {
+      float angle = 2 * float(M_PI) * h[i];
+      a[i] = std::cos(angle);
+      b[i] = std::sin(angle);
+    }
+
+    oklch_chunk(
+        lightness + start, chroma + start, h, a, b, size, out + start, clipped, map, table);
+
+    if (out_of_gamut)
+      std::memcpy(out_of_gamut + start, clipped, size);
+  }
+}
+
+/**
+ * \brief Splits an a/b vector into chroma, hue in [0-1) and the hue unit vector
+ */
+static void oklab_polar(float a, float b, float& chroma, float& hue, float& unit_a, float& unit_b)
+{
+  chroma = std::sqrt(a * a + b * b);
+  hue = std::atan2(b, a) / (2 * float(M_PI));
+  if (hue < 0)
+    hue += 1;
+  // Grays have no hue, any direction gives the same color
+  unit_a = chroma > 0 ? a / chroma : 1;
+  unit_b = chroma > 0 ? b / chroma : 0;
+}
+
+void oklab_to_rgb(
+    const float* lightness,
+    const float* a,
+    const float* b,
+    int count,
+    QRgb* out,
+    quint8* out_of_gamut,
+    bool map,
+    const oklch_chroma_table* table)
+{
+  float c[chunk], h[chunk], ua[chunk], ub[chunk];
+  quint8 clipped[chunk];
+
+  for (int start = 0; start < count; start += chunk)
+  {
+    int size = math::min(chunk, count - start);
+    for (int i = 0; i < size; i++)
+      oklab_polar(a[start + i], b[start + i], c[i], h[i], ua[i], ub[i]);
+
+    oklch_chunk(lightness + start, c, h, ua, ub, size, out + start, clipped, map, table);
+
+    if (out_of_gamut)
+      std::memcpy(out_of_gamut + start, clipped, size);
+  }
+}
+
+oklab oklab_map_to_gamut(const oklab& color)
+{
+  if (in_gamut(oklab_to_linear(color)))
+    return color;
+
+  float chroma, hue, unit_a, unit_b;
+  oklab_polar(color.a, color.b, chroma, hue, unit_a, unit_b);
+  float max_chroma = oklch_chroma_table::instance().max_chroma(color.l, hue);
+  if (chroma <= max_chroma)
+    return color;
+  return {color.l, unit_a * max_chroma, unit_b * max_chroma};
+}
+
+} // namespace detail
+} // namespace color_widgets
@@ -0,0 +1,135 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+#include "color_core.hpp"
+
+#include <QColor>
+
+#include <vector>
+
+// Conversions of runs of cylindrical colors to RGB, with out of gamut colors
+// either clipped or brought in gamut by reducing their chroma.
+// The loops work on plain arrays so the compiler can vectorize them.
+
+namespace color_widgets
+{
+namespace detail
+{
+
+/**
+ * \brief Maximum in gamut OKLab chroma, sampled by hue and lightness
+ *
+ * Lookups interpolate between samples so they can end up slightly off the
+ * gamut boundary, oklch_to_rgb() only maps colors actually out of gamut and
+ * clips what's left.
+ */
+class oklch_chroma_table
+{
+public:
+  static const int hue_steps = 360;
+  static const int lightness_steps = 100;
+
+  /**
+   * \brief Shared table, computed on first use
+   */
+  static const oklch_chroma_table& instance();
+
+  /**
+   * \param lightness OKLab lightness in [0-1]
+   * \param hue       Hue in [0-1]
+   */
+  float max_chroma(float lightness, float hue) const;
+
+private:
+  oklch_chroma_table();
+
+  std::vector<float> values; ///< lightness_steps + 1 values for each hue
+};
+
+/**
+ * \brief Converts colors from hue, chroma and Y'601 luma, as rgb_from_lch()
+ * \param map          Whether to reduce chroma (as rgb_from_lch_mapped())
+ *                     or to clip the channels
+ * \param out_of_gamut If not null, set to 1 for colors outside of the gamut
+ */
+void lch_to_rgb(
+    const float* hue,
+    const float* chroma,
+    const float* luma,
+    int count,
+    QRgb* out,
+    quint8* out_of_gamut,
+    bool map);
+
+/**
+ * \brief Converts colors from OKLab lightness, chroma and hue (in [0-1])
+ * \param map          Whether to reduce chroma or to clip the channels
+ * \param out_of_gamut If not null, set to 1 for colors outside of the gamut
+ * \param table        If not null, used to find the maximum chroma instead
+ *                     of a binary search for each color
+ */
+void oklch_to_rgb(
+    const float* lightness,
+    const float* chroma,
+    const float* hue,
+    int count,
+    QRgb* out,
+    quint8* out_of_gamut,
+    bool map,
+    const oklch_chroma_table* table = &oklch_chroma_table::instance());
+
+/**
+ * \brief Converts colors from OKLab lightness, a and b
+ *
+ * Same as oklch_to_rgb(), for colors laid out on the a/b plane rather than
+ * by chroma and hue.
+ */
+void oklab_to_rgb(
+    const float* lightness,
+    const float* a,
+    const float* b,
+    int count,
+    QRgb* out,
+    quint8* out_of_gamut,
+    bool map,
+    const oklch_chroma_table* table = &oklch_chroma_table::instance());
+
+/**
+ * \brief Brings an OKLab color in gamut by reducing its chroma
+ *
+ * Lightness and hue are kept, this is the mapping used by oklab_to_rgb().
+ * Colors already in gamut are returned unchanged.
+ */
+oklab oklab_map_to_gamut(const oklab& color);
+
+/**
+ * \brief Pixel with diagonal stripes, to mark out of gamut colors
+ */
+inline QRgb out_of_gamut_marker(QRgb pixel, int x, int y)
+{
+  if ((x + y) / 3 % 2)
+    return pixel;
+  return qRgb((qRed(pixel) + 128) / 2, (qGreen(pixel) + 128) / 2, (qBlue(pixel) + 128) / 2);
+}
+
+} // namespace detail
+} // namespace color_widgets
@@ -0,0 +1,576 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "gradient_editor.hpp"
+
+#include "color_utils.hpp"
+#include "gradient_sampler.hpp"
+
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+
+#include <algorithm>
+#include <cmath>
+
+#include <wobjectimpl.h>
+W_OBJECT_IMPL(color_widgets::GradientEditor)
+namespace color_widgets
+{
+
+/// Size of the stop handles
+static const int handle_size = 8;
+/// Distance from the widget a stop has to be dragged to be removed
+static const int remove_distance = 24;
+
+class GradientEditor::Private
+{
+public:
+  GradientEditor* w;
+  QGradientStops stops;
+  detail::gradient_sampler sampler;
+  Qt::Orientation orientation;
+  QBrush back;
+  int selected = -1;
+  QImage strip;
+  /// Positions the strip has to be rendered again for, empty if from > to
+  qreal dirty_from = 0;
+  qreal dirty_to = 1;
+  int drag_stop = -1;
+  qreal drag_offset = 0;
+  /// Whether the dragged stop has been dragged away and removed
+  bool drag_removed = false;
+  QGradientStop drag_saved;
+
+  Private(GradientEditor* widget, Qt::Orientation orientation)
+      : w(widget),
+        stops{{0, Qt::black}, {1, Qt::white}},
+        sampler(stops),
+        orientation(orientation),
+        back(Qt::darkGray, Qt::DiagCrossPattern)
+  {
+    back.setTexture(detail::alpha_pixmap());
+  }
+
+  /**
+   * \brief Marks the gradient between \p from and \p to to be rendered again
+   */
+  void invalidate(qreal from = 0, qreal to = 1)
+  {
+    dirty_from = qMin(dirty_from, from);
+    dirty_to = qMax(dirty_to, to);
+    w->update();
+  }
+
+  /**
+   * \brief Marks the part of the gradient depending on the stop at \p index
+   */
+  void invalidate_stop(int index)
+  {
+    invalidate(
+        index > 0 ? stops.at(index - 1).first : 0,
+        index + 1 < stops.size() ? stops.at(index + 1).first : 1);
+  }
+
+  int insert(const QGradientStop& stop)
+  {
+    auto it = std::upper_bound(
+        stops.begin(), stops.end(), stop.first, [](qreal pos, const QGradientStop& stop) {
+          return pos < stop.first;
+        });
+    int index = int(it - stops.begin());
+    stops.insert(index, stop);
+    sampler.insert(index, stop);
+    invalidate_stop(index);
+    return index;
+  }
+
+  void erase(int index)
+  {
+    invalidate_stop(index);
+    stops.remove(index);
+    sampler.erase(index);
+  }
+
+  /**
+   * \brief Updates the selected index after removing the stop at \p removed
+   * and inserting one at \p inserted (-1 for none)
+   * \returns Whether the selected index has changed
+   */
+  bool reindex_selection(int removed, int inserted)
+  {
+    int index = selected;
+    if (index >= 0 && index == removed)
+    {
+      index = inserted;
+    }
+    else if (index >= 0)
+    {
+      if (removed >= 0 && index > removed)
+        index--;
+      if (inserted >= 0 && index >= inserted)
+        index++;
+    }
+
+    if (index == selected)
+      return false;
+    selected = index;
+    return true;
+  }
+
+  void set_selected(int index)
+  {
+    if (index != selected)
+    {
+      selected = index;
+      w->update();
+      w->selectedStopChanged(index);
+    }
+  }
+
+  /**
+   * \brief Area covered by the gradient, the handles are below or to its right
+   */
+  QRect bar_rect() const
+  {
+    QRect rect = w->contentsRect();
+    int half = handle_size / 2;
+    if (orientation == Qt::Horizontal)
+      return rect.adjusted(half, 0, -half, -handle_size);
+    return rect.adjusted(0, half, -handle_size, -half);
+  }
+
+  int length(const QRect& bar) const
+  {
+    return orientation == Qt::Horizontal ? bar.width() : bar.height();
+  }
+
+  /**
+   * \brief Distance between two pixels of the gradient, as a position
+   */
+  qreal pixel_step() const
+  {
+    int len = length(bar_rect());
+    return len > 1 ? 1. / (len - 1) : 0;
+  }
+
+  /**
+   * \brief Gradient position under \p pos, not bounded to [0, 1]
+   */
+  qreal position_at(const QPoint& pos) const
+  {
+    QRect bar = bar_rect();
+    if (orientation == Qt::Horizontal)
+      return (pos.x() - bar.left()) * pixel_step();
+    return (pos.y() - bar.top()) * pixel_step();
+  }
+
+  /**
+   * \brief Distance of \p pos outside the widget, across the gradient
+   */
+  int distance_away(const QPoint& pos) const
+  {
+    if (orientation == Qt::Horizontal)
+      return qMax(-pos.y(), pos.y() - w->height());
+    return qMax(-pos.x(), pos.x() - w->width());
+  }
+
+  /**
+   * \brief Renders the invalidated part of \p strip, or all of it on resize
+   * \param length Length of the bar in logical pixels
+   * \param ratio  Device pixel ratio, one color is rendered per device pixel
+   */
+  void render(int length, qreal ratio)
+  {
+    length = qRound(length * ratio);
+    if (length <= 0)
+      return;
+
+    QSize size = orientation == Qt::Horizontal ? QSize(length, 1) : QSize(1, length);
+    if (strip.size() != size || strip.devicePixelRatio() != ratio)
+    {
+      strip = QImage(size, QImage::Format_ARGB32);
+      strip.setDevicePixelRatio(ratio);
+      dirty_from = 0;
+      dirty_to = 1;
+    }
+    if (dirty_from > dirty_to)
+      return;
+
+    // One more pixel on each side for positions rounded differently
+    int from = qMax(0, int(std::floor(dirty_from * (length - 1))) - 1);
+    int to = qMin(length, int(std::ceil(dirty_to * (length - 1))) + 2);
+    dirty_from = 1;
+    dirty_to = 0;
+
+    float step = length > 1 ? 1.f / (length - 1) : 0;
+    QRgb* out = reinterpret_cast<QRgb*>(strip.bits());
+    sampler.sample(from, step, to - from, out + from);
+  }
+
+  /**
+   * \brief Draws the line across the gradient and the handle of a stop
+   */
+  void paint_stop(QPainter& painter, const QRect& bar, int index) const
+  {
+    const QGradientStop& stop = stops[index];
+    qreal offset = stop.first * (length(bar) - 1) + 0.5;
+    QColor line_color = detail::color_lumaF(stop.second) > 0.5 || stop.second.alphaF() < 0.2
+                            ? Qt::black
+                            : Qt::white;
+
+    QLineF line;
+    QRectF handle;
+    if (orientation == Qt::Horizontal)
+    {
+      qreal x = bar.left() + offset;
+      line = QLineF(x, bar.top(), x, bar.bottom() + 1);
+      handle = QRectF(x - handle_size / 2., bar.bottom() + 1.5, handle_size, handle_size - 2);
+    }
+    else
+    {
+      qreal y = bar.top() + offset;
+      line = QLineF(bar.left(), y, bar.right() + 1, y);
+      handle = QRectF(bar.right() + 1.5, y - handle_size / 2., handle_size - 2, handle_size);
+    }
+
+    bool current = index == selected;
+    painter.setPen(QPen(line_color, current ? 2 : 1));
+    painter.drawLine(line);
+    QPalette::ColorRole border = current ? QPalette::Highlight : QPalette::WindowText;
+    painter.setPen(QPen(w->palette().color(border), current ? 2 : 1));
+    painter.setBrush(stop.second);
+    painter.drawRect(handle);
+  }
+};
+
+GradientEditor::GradientEditor(QWidget* parent) : GradientEditor(Qt::Horizontal, parent)
+{
+}
+
+GradientEditor::GradientEditor(Qt::Orientation orientation, QWidget* parent)
+    : QWidget(parent), p(new Private(this, orientation))
+{
+  setFocusPolicy(Qt::StrongFocus);
+}
+
+GradientEditor::~GradientEditor()
+{
+  delete p;
+}
+
+QSize GradientEditor::sizeHint() const
+{
+  if (p->orientation == Qt::Horizontal)
+    return QSize(192, 24 + handle_size);
+  return QSize(24 + handle_size, 192);
+}
+
+QGradientStops GradientEditor::stops() const
+{
+  return p->stops;
+}
+
+Qt::Orientation GradientEditor::orientation() const
+{
+  return p->orientation;
+}
+
+GradientEditor::Interpolation GradientEditor::interpolation() const
+{
+  return p->sampler.interpolation();
+}
+
+int GradientEditor::selectedStop() const
+{
+  return p->selected;
+}
+
+QBrush GradientEditor::background() const
+{
+  return p->back;
+}
+
+void GradientEditor::setBackground(const QBrush& bg)
+{
+  p->back = bg;
+  update();
+}
+
+QColor GradientEditor::colorAt(qreal position) const
+{
+  if (p->stops.isEmpty())
+    return QColor();
+
+  QRgb color;
+  p->sampler.sample(float(position), 1, 1, &color);
+  return QColor::fromRgba(color);
+}
+
+int GradientEditor::stopAt(const QPoint& pos) const
+{
+  const QGradientStops& stops = p->stops;
+  qreal step = p->pixel_step();
+  if (stops.isEmpty() || step == 0)
+    return -1;
+
+  // Stops are sorted so only the ones in reach of the handle are checked
+  qreal position = p->position_at(pos);
+  qreal radius = handle_size / 2. * step;
+  auto it = std::lower_bound(
+      stops.begin(), stops.end(), position - radius,
+      [](const QGradientStop& stop, qreal pos) { return stop.first < pos; });
+
+  // Ties go to the later stop, which is drawn on top
+  int found = -1;
+  qreal found_distance = radius;
+  for (; it != stops.end() && it->first <= position + radius; ++it)
+  {
+    qreal distance = qAbs(it->first - position);
+    if (distance <= found_distance)
+    {
+      found = int(it - stops.begin());
+      found_distance = distance;
+    }
+  }
+  return found;
+}
+
+int GradientEditor::insertStop(qreal position, const QColor& color)
+{
+  int index = p->insert({qBound(0., position, 1.), color});
+  bool selection = p->reindex_selection(-1, index);
+  stopsChanged(p->stops);
+  if (selection)
+    selectedStopChanged(p->selected);
+  return index;
+}
+
+int GradientEditor::moveStop(int index, qreal position)
+{
+  if (index < 0 || index >= p->stops.size())
+    return -1;
+
+  QGradientStop stop = p->stops.at(index);
+  stop.first = qBound(0., position, 1.);
+  if (stop.first == p->stops.at(index).first)
+    return index;
+
+  p->erase(index);
+  int moved = p->insert(stop);
+  bool selection = p->reindex_selection(index, moved);
+  stopsChanged(p->stops);
+  if (selection)
+    selectedStopChanged(p->selected);
+  return moved;
+}
+
+void GradientEditor::setStopColor(int index, const QColor& color)
+{
+  if (index < 0 || index >= p->stops.size() || p->stops.at(index).second == color)
+    return;
+
+  p->stops[index].second = color;
+  p->sampler.replace(index, p->stops.at(index));
+  p->invalidate_stop(index);
+  stopsChanged(p->stops);
+}
+
+void GradientEditor::removeStop(int index)
+{
+  if (index < 0 || index >= p->stops.size())
+    return;
+
+  p->erase(index);
+  bool selection = p->reindex_selection(index, -1);
+  stopsChanged(p->stops);
+  if (selection)
+    selectedStopChanged(p->selected);
+}
+
+void GradientEditor::setStops(const QGradientStops& stops)
+{
+  QGradientStops sorted = stops;
+  for (QGradientStop& stop : sorted)
+    stop.first = qBound(0., stop.first, 1.);
+  std::stable_sort(
+      sorted.begin(), sorted.end(), [](const QGradientStop& a, const QGradientStop& b) {
+        return a.first < b.first;
+      });
+  if (sorted == p->stops)
+    return;
+
+  p->stops = sorted;
+  p->sampler.load(p->stops, p->sampler.interpolation());
+  p->invalidate();
+  bool selection = p->selected >= p->stops.size();
+  if (selection)
+    p->selected = -1;
+  stopsChanged(p->stops);
+  if (selection)
+    selectedStopChanged(p->selected);
+}
+
+void GradientEditor::setOrientation(Qt::Orientation orientation)
+{
+  if (orientation != p->orientation)
+  {
+    p->orientation = orientation;
+    updateGeometry();
+    update();
+  }
+}
+
+void GradientEditor::setInterpolation(Interpolation interpolation)
+{
+  if (interpolation != p->sampler.interpolation())
+  {
+    p->sampler.load(p->stops, interpolation);
+    p->invalidate();
+    interpolationChanged(interpolation);
+  }
+}
+
+void GradientEditor::setSelectedStop(int index)
+{
+  p->set_selected(index >= 0 && index < p->stops.size() ? index : -1);
+}
+
+void GradientEditor::setSelectedColor(const QColor& color)
+{
+  setStopColor(p->selected, color);
+}
+
+void GradientEditor::paintEvent(QPaintEvent*)
+{
+  detail::simulated_painter painter(this);
+
+  QRect bar = p->bar_rect();
+  painter.setPen(Qt::NoPen);
+  painter.setBrush(p->back);
+  painter.drawRect(bar);
+  p->render(p->length(bar), devicePixelRatioF());
+  painter.drawImage(bar, p->strip);
+
+  painter.setPen(palette().color(QPalette::Mid));
+  painter.setBrush(Qt::NoBrush);
+  painter.drawRect(bar.adjusted(0, 0, -1, -1));
+
+  painter.setRenderHint(QPainter::Antialiasing);
+  for (int i = 0; i < p->stops.size(); i++)
+    p->paint_stop(painter, bar, i);
+}
+
+void GradientEditor::mousePressEvent(QMouseEvent* event)
+{
+  if (event->button() != Qt::LeftButton)
+    return QWidget::mousePressEvent(event);
+
+  int index = stopAt(event->pos());
+  p->set_selected(index);
+  p->drag_stop = index;
+  p->drag_removed = false;
+  if (index >= 0)
+    p->drag_offset = p->position_at(event->pos()) - p->stops.at(index).first;
+}
+
+void GradientEditor::mouseMoveEvent(QMouseEvent* event)
+{
+  if (p->drag_stop < 0)
+    return QWidget::mouseMoveEvent(event);
+
+  qreal position = p->position_at(event->pos()) - p->drag_offset;
+  bool away = p->distance_away(event->pos()) > remove_distance;
+  if (away && !p->drag_removed && p->stops.size() > 1)
+  {
+    // Kept aside so it can be put back if it's dragged back in
+    p->drag_saved = p->stops.at(p->drag_stop);
+    p->drag_removed = true;
+    removeStop(p->drag_stop);
+  }
+  else if (!away && p->drag_removed)
+  {
+    p->drag_removed = false;
+    p->drag_stop = insertStop(position, p->drag_saved.second);
+    setSelectedStop(p->drag_stop);
+  }
+  else if (!p->drag_removed)
+  {
+    p->drag_stop = moveStop(p->drag_stop, position);
+  }
+}
+
+void GradientEditor::mouseReleaseEvent(QMouseEvent* event)
+{
+  if (event->button() != Qt::LeftButton)
+    return QWidget::mouseReleaseEvent(event);
+
+  p->drag_stop = -1;
+  p->drag_removed = false;
+}
+
+void GradientEditor::mouseDoubleClickEvent(QMouseEvent* event)
+{
+  if (event->button() != Qt::LeftButton)
+    return QWidget::mouseDoubleClickEvent(event);
+
+  int index = stopAt(event->pos());
+  if (index >= 0)
+  {
+    stopDoubleClicked(index);
+    return;
+  }
+
+  qreal position = qBound(0., p->position_at(event->pos()), 1.);
+  setSelectedStop(insertStop(position, colorAt(position)));
+}
+
+void GradientEditor::keyPressEvent(QKeyEvent* event)
+{
+  int index = p->selected;
+  if (index < 0)
+    return QWidget::keyPressEvent(event);
+
+  switch (event->key())
+  {
+    default:
+      QWidget::keyPressEvent(event);
+      return;
+
+    case Qt::Key_Delete:
+    case Qt::Key_Backspace:
+      if (p->stops.size() > 1)
+        removeStop(index);
+      break;
+
+    case Qt::Key_Left:
+    case Qt::Key_Up:
+      moveStop(index, p->stops.at(index).first - p->pixel_step());
+      break;
+
+    case Qt::Key_Right:
+    case Qt::Key_Down:
+      moveStop(index, p->stops.at(index).first + p->pixel_step());
+      break;
+  }
+}
+
+} // namespace color_widgets
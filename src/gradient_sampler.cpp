@@ -0,0 +1,203 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "gradient_sampler.hpp"
+
+#include "color_utils.hpp"
+
+#include <algorithm>
+
+namespace color_widgets
+{
+namespace detail
+{
+
+/**
+ * \brief Conversions between sRGB and a space colors are interpolated in
+ */
+struct interpolation_space
+{
+  /// Components of \p color in the space
+  void (*decode)(const rgb_f& color, float* out);
+  /// Converts runs of components to opaque sRGB colors
+  void (*encode)(const float* const* c, int count, QRgb* out);
+};
+
+static quint8 to_8bit(float value)
+{
+  return quint8(math::clamp(value, 0.f, 1.f) * 255 + 0.5f);
+}
+
+static int encode_index(float linear)
+{
+  return int(math::clamp(linear, 0.f, 1.f) * srgb_encode_steps + 0.5f);
+}
+
+static void decode_rgb(const rgb_f& color, float* out)
+{
+  out[0] = color.r;
+  out[1] = color.g;
+  out[2] = color.b;
+}
+
+static void encode_rgb(const float* const* c, int count, QRgb* out)
+{
+  for (int i = 0; i < count; i++)
+    out[i] = qRgb(to_8bit(c[0][i]), to_8bit(c[1][i]), to_8bit(c[2][i]));
+}
+
+static void decode_linear(const rgb_f& color, float* out)
+{
+  out[0] = float(srgb_decode(color.r));
+  out[1] = float(srgb_decode(color.g));
+  out[2] = float(srgb_decode(color.b));
+}
+
+static void encode_linear(const float* const* c, int count, QRgb* out)
+{
+  const quint8* encode = srgb_encode_table();
+  for (int i = 0; i < count; i++)
+  {
+    out[i] = qRgb(
+        encode[encode_index(c[0][i])],
+        encode[encode_index(c[1][i])],
+        encode[encode_index(c[2][i])]);
+  }
+}
+
+static void decode_oklab(const rgb_f& color, float* out)
+{
+  float linear[3];
+  decode_linear(color, linear);
+  oklab lab = linear_to_oklab({linear[0], linear[1], linear[2]});
+  out[0] = lab.l;
+  out[1] = lab.a;
+  out[2] = lab.b;
+}
+
+static void encode_oklab(const float* const* c, int count, QRgb* out)
+{
+  const quint8* encode = srgb_encode_table();
+  for (int i = 0; i < count; i++)
+  {
+    rgb_f rgb = oklab_to_linear({c[0][i], c[1][i], c[2][i]});
+    out[i] = qRgb(
+        encode[encode_index(rgb.r)], encode[encode_index(rgb.g)], encode[encode_index(rgb.b)]);
+  }
+}
+
+/// Indexed by GradientEditor::Interpolation
+static const interpolation_space interpolation_spaces[] = {
+    {decode_rgb, encode_rgb},
+    {decode_linear, encode_linear},
+    {decode_oklab, encode_oklab},
+};
+
+gradient_sampler::gradient_sampler(
+    const QGradientStops& stops, GradientEditor::Interpolation interpolation)
+{
+  load(stops, interpolation);
+}
+
+void gradient_sampler::load(
+    const QGradientStops& stops, GradientEditor::Interpolation interpolation)
+{
+  space = interpolation;
+  coords.clear();
+  coords.reserve(stops.size());
+  for (const QGradientStop& stop : stops)
+    coords.push_back(to_coords(stop));
+}
+
+void gradient_sampler::insert(int index, const QGradientStop& stop)
+{
+  coords.insert(coords.begin() + index, to_coords(stop));
+}
+
+void gradient_sampler::erase(int index)
+{
+  coords.erase(coords.begin() + index);
+}
+
+void gradient_sampler::replace(int index, const QGradientStop& stop)
+{
+  coords[index] = to_coords(stop);
+}
+
+gradient_sampler::stop_coords gradient_sampler::to_coords(const QGradientStop& stop) const
+{
+  stop_coords out;
+  out.pos = float(stop.first);
+  interpolation_spaces[space].decode(color_rgbF(stop.second), out.c);
+  out.c[3] = float(stop.second.alphaF());
+  for (int i = 0; i < 3; i++)
+    out.c[i] *= out.c[3];
+  return out;
+}
+
+void gradient_sampler::sample(float origin, float step, int count, QRgb* out) const
+{
+  if (coords.empty())
+  {
+    std::fill(out, out + count, QRgb(0));
+    return;
+  }
+
+  std::vector<float> values(count * 4);
+  float* c[4] = {
+      values.data(), values.data() + count, values.data() + count * 2, values.data() + count * 3};
+
+  // First stop past the current position, found once and then advanced
+  auto next = std::upper_bound(
+      coords.begin(), coords.end(), origin * step, [](float pos, const stop_coords& stop) {
+        return pos < stop.pos;
+      });
+  for (int i = 0; i < count; i++)
+  {
+    float t = (origin + i) * step;
+    while (next != coords.end() && next->pos <= t)
+      ++next;
+
+    const stop_coords& after = next == coords.end() ? coords.back() : *next;
+    const stop_coords& before = next == coords.begin() ? coords.front() : *(next - 1);
+    float f = after.pos > before.pos ? (t - before.pos) / (after.pos - before.pos) : 0;
+    for (int k = 0; k < 4; k++)
+      c[k][i] = before.c[k] + (after.c[k] - before.c[k]) * f;
+  }
+
+  for (int i = 0; i < count; i++)
+  {
+    float alpha = c[3][i];
+    if (alpha > 0)
+    {
+      c[0][i] /= alpha;
+      c[1][i] /= alpha;
+      c[2][i] /= alpha;
+    }
+  }
+
+  interpolation_spaces[space].encode(c, count, out);
+  for (int i = 0; i < count; i++)
+    out[i] = (out[i] & RGB_MASK) | uint(to_8bit(c[3][i])) << 24;
+}
+
+} // namespace detail
+} // namespace color_widgets
@@ -0,0 +1,85 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+#include "gradient_editor.hpp"
+
+#include <QColor>
+
+#include <vector>
+
+namespace color_widgets
+{
+namespace detail
+{
+
+/**
+ * \brief Interpolates the colors of gradient stops, a run of colors at a time
+ *
+ * Each stop is converted to the interpolation space once, when it's added.
+ * Interpolation uses premultiplied alpha.
+ */
+class gradient_sampler
+{
+public:
+  explicit gradient_sampler(
+      const QGradientStops& stops = QGradientStops(),
+      GradientEditor::Interpolation interpolation = GradientEditor::Rgb);
+
+  /**
+   * \brief Replaces all the stops, they must be sorted by position
+   */
+  void load(const QGradientStops& stops, GradientEditor::Interpolation interpolation);
+
+  void insert(int index, const QGradientStop& stop);
+  void erase(int index);
+  void replace(int index, const QGradientStop& stop);
+
+  GradientEditor::Interpolation interpolation() const { return space; }
+
+  /**
+   * \brief Renders \p count colors, the one at index \p i is at position
+   * <tt>(origin + i) * step</tt>
+   *
+   * Positions are computed from whole indices so rendering part of a run
+   * gives the same colors as rendering all of it.
+   * Without stops all the colors are transparent.
+   */
+  void sample(float origin, float step, int count, QRgb* out) const;
+
+private:
+  /**
+   * \brief Stop color in the interpolation space, premultiplied by alpha
+   */
+  struct stop_coords
+  {
+    float pos;
+    float c[4]; ///< Components followed by alpha
+  };
+
+  stop_coords to_coords(const QGradientStop& stop) const;
+
+  std::vector<stop_coords> coords;
+  GradientEditor::Interpolation space;
+};
+
+} // namespace detail
+} // namespace color_widgets
@@ -154,7 +154,7 @@ QColor GradientSlider::lastColor() const
 
 void GradientSlider::paintEvent(QPaintEvent*)
 {
-  QPainter painter(this);
+  detail::simulated_painter painter(this);
 
   QStyleOptionFrame panel;
   panel.initFrom(this);
@@ -170,19 +170,15 @@ void GradientSlider::paintEvent(QPaintEvent*)
   else
     p->gradient.setFinalStop(0, 1);
 
-  painter.setPen(p->border);
-  painter.setBrush(p->back);
-  painter.drawRect(
-      1 + p->border.width(),
-      1 + p->border.width() + p->verticalSpacing,
-      geometry().width() - 2 - p->border.width() * 2,
-      geometry().height() - 2 - p->verticalSpacing * 2 - p->border.width() * 2);
-  painter.setBrush(p->gradient);
-  painter.drawRect(
+  QRect gradient_rect(
       1 + p->border.width(),
       1 + p->border.width() + p->verticalSpacing,
       geometry().width() - 2 - p->border.width() * 2,
       geometry().height() - 2 - p->verticalSpacing * 2 - p->border.width() * 2);
+  painter.setPen(p->border);
+  painter.setBrush(p->back);
+  painter.drawRect(gradient_rect);
+  paintGradient(painter, gradient_rect);
 
   painter.setClipping(false);
   QStyleOptionSlider opt_slider;
@@ -200,4 +196,10 @@ void GradientSlider::paintEvent(QPaintEvent*)
   style()->drawComplexControl(QStyle::CC_Slider, &opt_slider, &painter, this);
 }
 
+void GradientSlider::paintGradient(QPainter& painter, const QRect& rect)
+{
+  painter.setBrush(p->gradient);
+  painter.drawRect(rect);
+}
+
 } // namespace color_widgets
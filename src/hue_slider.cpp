@@ -22,6 +22,8 @@
  */
 #include "hue_slider.hpp"
 
+#include "update_guard.hpp"
+
 #include <wobjectimpl.h>
 W_OBJECT_IMPL(color_widgets::HueSlider)
 namespace color_widgets
@@ -33,35 +35,29 @@ private:
   HueSlider* w;
 
 public:
-  qreal saturation = 1;
-  qreal value = 1;
-  qreal alpha = 1;
+  bool updating = false;
 
   Private(HueSlider* widget) : w(widget)
   {
     w->setRange(0, 359);
+    w->setModel(Hsv);
+    w->setComponent(Hue);
     connect(w, &QSlider::valueChanged, [this] { w->colorHueChanged(percent()); });
-    updateGradient();
   }
 
-  void updateGradient()
+  /// Sets the context keeping the components that aren't given
+  void set_context(qreal saturation, qreal value, qreal alpha)
   {
-    static const double n_colors = 6;
-    QGradientStops colors;
-    colors.reserve(n_colors + 1);
-    for (int i = 0; i <= n_colors; ++i)
-      colors.append(
-          QGradientStop(i / n_colors, QColor::fromHsvF(i / n_colors, saturation, value)));
-    w->setColors(colors);
+    w->setContext(ColorF::fromHsvF(percent(), saturation, value, alpha));
   }
 
   qreal percent() { return qreal(w->value() - w->minimum()) / (w->maximum() - w->minimum()); }
 };
 
-HueSlider::HueSlider(QWidget* parent) : GradientSlider(parent), p(new Private(this)) { }
+HueSlider::HueSlider(QWidget* parent) : ComponentSlider(parent), p(new Private(this)) { }
 
 HueSlider::HueSlider(Qt::Orientation orientation, QWidget* parent)
-    : GradientSlider(orientation, parent), p(new Private(this))
+    : ComponentSlider(orientation, parent), p(new Private(this))
 {
 }
 
@@ -72,53 +68,72 @@ HueSlider::~HueSlider()
 
 qreal HueSlider::colorSaturation() const
 {
-  return p->saturation;
+  return context().s;
 }
 
 void HueSlider::setColorSaturation(qreal s)
 {
-  p->saturation = qBound(0.0, s, 1.0);
-  p->updateGradient();
+  s = qBound(0.0, s, 1.0);
+  detail::update_guard guard(p->updating);
+  if (!guard.enter(!detail::fuzzy_same(s, colorSaturation())))
+    return;
+
+  p->set_context(s, colorValue(), colorAlpha());
 }
 
 qreal HueSlider::colorValue() const
 {
-  return p->value;
+  return context().v;
 }
 
 void HueSlider::setColorValue(qreal v)
 {
-  p->value = qBound(0.0, v, 1.0);
-  p->updateGradient();
+  v = qBound(0.0, v, 1.0);
+  detail::update_guard guard(p->updating);
+  if (!guard.enter(!detail::fuzzy_same(v, colorValue())))
+    return;
+
+  p->set_context(colorSaturation(), v, colorAlpha());
 }
 
 qreal HueSlider::colorAlpha() const
 {
-  return p->alpha;
+  return context().a;
 }
 
 void HueSlider::setColorAlpha(qreal alpha)
 {
-  p->alpha = alpha;
-  p->updateGradient();
+  p->set_context(colorSaturation(), colorValue(), alpha);
 }
 
 QColor HueSlider::color() const
 {
-  return QColor::fromHsvF(p->percent(), p->saturation, p->value, p->alpha);
+  return ComponentSlider::color();
 }
 
 void HueSlider::setColor(const QColor& color)
 {
-  p->saturation = color.saturationF();
-  p->value = color.valueF();
-  p->updateGradient();
-  setColorHue(color.hueF());
+  qreal hue = color.hsvHueF();
+  qreal saturation = color.hsvSaturationF();
+  qreal value = color.valueF();
+  // Grays have no hue, keep the current one
+  bool has_hue = hue >= 0;
+
+  detail::update_guard guard(p->updating);
+  bool changed = !detail::fuzzy_same(saturation, colorSaturation())
+                 || !detail::fuzzy_same(value, colorValue())
+                 || (has_hue && !detail::fuzzy_same(hue, colorHue()));
+  if (!guard.enter(changed))
+    return;
+
+  p->set_context(saturation, value, colorAlpha());
+  if (has_hue)
+    setColorHue(hue);
 }
 
 void HueSlider::setFullColor(const QColor& color)
 {
-  p->alpha = color.alphaF();
+  p->set_context(colorSaturation(), colorValue(), color.alphaF());
   setColor(color);
 }
 
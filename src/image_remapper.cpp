@@ -0,0 +1,406 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "image_remapper.hpp"
+
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <vector>
+
+namespace color_widgets
+{
+
+namespace
+{
+/// Writes palette indices to the output buffer
+struct Output
+{
+  enum Kind
+  {
+    Indexed8,
+    Rgb32,
+    Index16,
+  };
+
+  uchar* bits;
+  int bytes_per_line;
+  Kind kind;
+  const QRgb* colors;
+
+  void set(int y, int x, int index) const
+  {
+    uchar* line = bits + qptrdiff(y) * bytes_per_line;
+    switch (kind)
+    {
+      case Indexed8:
+        line[x] = uchar(index);
+        break;
+      case Rgb32:
+        reinterpret_cast<QRgb*>(line)[x] = colors[index];
+        break;
+      case Index16:
+        reinterpret_cast<quint16*>(line)[x] = quint16(index);
+        break;
+    }
+  }
+};
+} // namespace
+
+/// Thresholds of the 8x8 Bayer matrix, in [0, 63]
+static const int bayer_matrix[64] = {
+    0,  32, 8,  40, 2,  34, 10, 42, 48, 16, 56, 24, 50, 18, 58, 26, 12, 44, 4,  36, 14, 46,
+    6,  38, 60, 28, 52, 20, 62, 30, 54, 22, 3,  35, 11, 43, 1,  33, 9,  41, 51, 19, 59, 27,
+    49, 17, 57, 25, 15, 47, 7,  39, 13, 45, 5,  37, 63, 31, 55, 23, 61, 29, 53, 21,
+};
+
+class ImageRemapper::Private
+{
+public:
+  QVector<QRgb> colors;
+  int bits = 5;
+  Dithering dithering = NoDithering;
+  int threads = 0;
+  /// Index of the nearest color for each quantized RGB value
+  QVector<quint16> lookup;
+
+  int lookup_index(int r, int g, int b) const
+  {
+    int shift = 8 - bits;
+    return (r >> shift) << (2 * bits) | (g >> shift) << bits | (b >> shift);
+  }
+
+  int nearest(int r, int g, int b) const { return lookup[lookup_index(r, g, b)]; }
+
+  void build_lookup()
+  {
+    lookup.clear();
+    if (colors.empty())
+      return;
+
+    int side = 1 << bits;
+    int size = side * side * side;
+    lookup.resize(size);
+
+    // Separate channels so the inner loop doesn't unpack the colors
+    int count = colors.size();
+    QVector<int> channels(count * 3);
+    for (int i = 0; i < count; i++)
+    {
+      channels[i * 3] = qRed(colors[i]);
+      channels[i * 3 + 1] = qGreen(colors[i]);
+      channels[i * 3 + 2] = qBlue(colors[i]);
+    }
+
+    const int* palette = channels.constData();
+    quint16* out = lookup.data();
+    int shift = 8 - bits;
+    int half = 1 << (shift - 1);
+    int threads = detail::thread_count(this->threads, size / 4096);
+
+    detail::parallel_for(0, size, threads, [=](int from, int to) {
+      for (int cell = from; cell < to; cell++)
+      {
+        // Center of the cell
+        int r = (cell >> (2 * bits)) << shift | half;
+        int g = ((cell >> bits) & (side - 1)) << shift | half;
+        int b = (cell & (side - 1)) << shift | half;
+
+        int best = 0;
+        int best_dist = INT_MAX;
+        for (int i = 0; i < count && best_dist > 0; i++)
+        {
+          int dr = palette[i * 3] - r;
+          int dg = palette[i * 3 + 1] - g;
+          int db = palette[i * 3 + 2] - b;
+          int dist = dr * dr + dg * dg + db * db;
+          if (dist < best_dist)
+          {
+            best = i;
+            best_dist = dist;
+          }
+        }
+        out[cell] = quint16(best);
+      }
+    });
+  }
+
+  void remap(const QImage& source, const Output& output) const
+  {
+    switch (dithering)
+    {
+      case NoDithering:
+        remap_plain(source, output);
+        break;
+      case OrderedDithering:
+        remap_ordered(source, output);
+        break;
+      case ErrorDiffusion:
+        remap_diffused(source, output);
+        break;
+    }
+  }
+
+  void remap_plain(const QImage& source, const Output& output) const
+  {
+    int width = source.width();
+    detail::parallel_for(
+        0, source.height(), detail::thread_count(threads, source.height()), [&](int from, int to) {
+          for (int y = from; y < to; y++)
+          {
+            auto line = reinterpret_cast<const QRgb*>(source.constScanLine(y));
+            for (int x = 0; x < width; x++)
+              output.set(y, x, nearest(qRed(line[x]), qGreen(line[x]), qBlue(line[x])));
+          }
+        });
+  }
+
+  void remap_ordered(const QImage& source, const Output& output) const
+  {
+    // Scale the thresholds to about the average distance between colors
+    int spread = qBound(8, qRound(255 / std::cbrt(float(colors.size()))), 255);
+    int offsets[64];
+    for (int i = 0; i < 64; i++)
+      offsets[i] = (bayer_matrix[i] * 2 - 63) * spread / 128;
+
+    int width = source.width();
+    detail::parallel_for(
+        0, source.height(), detail::thread_count(threads, source.height()), [&](int from, int to) {
+          for (int y = from; y < to; y++)
+          {
+            auto line = reinterpret_cast<const QRgb*>(source.constScanLine(y));
+            const int* row_offsets = offsets + (y & 7) * 8;
+            for (int x = 0; x < width; x++)
+            {
+              int offset = row_offsets[x & 7];
+              output.set(
+                  y,
+                  x,
+                  nearest(
+                      qBound(0, qRed(line[x]) + offset, 255),
+                      qBound(0, qGreen(line[x]) + offset, 255),
+                      qBound(0, qBlue(line[x]) + offset, 255)));
+            }
+          }
+        });
+  }
+
+  /**
+   * \brief Floyd-Steinberg error diffusion
+   *
+   * Threads take the next row when they finish one. A pixel can be
+   * processed once the row above is done up to the pixel on its right, as
+   * that's the last one diffusing error into it, so rows run in a wavefront
+   * a couple of pixels behind each other. Rows are taken in order, so the
+   * row being waited for is always being processed, even if the pool runs
+   * fewer threads than requested.
+   */
+  void remap_diffused(const QImage& source, const Output& output) const
+  {
+    int width = source.width();
+    int height = source.height();
+    int threads = detail::thread_count(this->threads, height);
+    // Pixels between progress updates
+    const int publish_step = 32;
+
+    // Error (in 1/16) diffused into the rows being processed. Row y reads
+    // buffer y and writes buffer y+1 modulo the number of slots, when row y
+    // starts the previous user of buffer y+1 (row y-threads) is done: at most
+    // threads rows are in progress and a row only ends after the one above.
+    // Error diffused to the right stays in a local so each buffer is only
+    // written by the row above.
+    int slots = threads + 1;
+    int stride = (width + 2) * 3;
+    std::vector<int> errors(slots * stride, 0);
+    std::vector<std::atomic<int>> progress(height);
+    std::atomic<int> next_row(0);
+
+    detail::run_threads(threads, [&](int) {
+      for (int y = next_row++; y < height; y = next_row++)
+      {
+        int* current = errors.data() + (y % slots) * stride + 3;
+        int* next = errors.data() + ((y + 1) % slots) * stride + 3;
+        std::fill(next - 3, next - 3 + stride, 0);
+
+        auto line = reinterpret_cast<const QRgb*>(source.constScanLine(y));
+        int ready = y == 0 ? width : 0;
+        int right[3] = {0, 0, 0};
+
+        for (int x = 0; x < width; x++)
+        {
+          int needed = qMin(width, x + 2);
+          while (ready < needed)
+          {
+            ready = progress[y - 1].load(std::memory_order_acquire);
+            if (ready < needed)
+              QThread::yieldCurrentThread();
+          }
+
+          int* error = current + x * 3;
+          int r = qBound(0, qRed(line[x]) + (error[0] + right[0]) / 16, 255);
+          int g = qBound(0, qGreen(line[x]) + (error[1] + right[1]) / 16, 255);
+          int b = qBound(0, qBlue(line[x]) + (error[2] + right[2]) / 16, 255);
+          int index = nearest(r, g, b);
+          output.set(y, x, index);
+
+          QRgb color = colors[index];
+          int diff[3] = {r - qRed(color), g - qGreen(color), b - qBlue(color)};
+          for (int c = 0; c < 3; c++)
+          {
+            right[c] = diff[c] * 7;
+            next[(x - 1) * 3 + c] += diff[c] * 3;
+            next[x * 3 + c] += diff[c] * 5;
+            next[(x + 1) * 3 + c] += diff[c];
+          }
+
+          if ((x + 1) % publish_step == 0)
+            progress[y].store(x + 1, std::memory_order_release);
+        }
+
+        progress[y].store(width, std::memory_order_release);
+      }
+    });
+  }
+};
+
+ImageRemapper::ImageRemapper(const ColorPalette& palette) : p(new Private)
+{
+  setPalette(palette);
+}
+
+ImageRemapper::ImageRemapper(const ImageRemapper& other) : p(new Private(*other.p)) { }
+
+ImageRemapper& ImageRemapper::operator=(const ImageRemapper& other)
+{
+  *p = *other.p;
+  return *this;
+}
+
+ImageRemapper::~ImageRemapper()
+{
+  delete p;
+}
+
+void ImageRemapper::setPalette(const ColorPalette& palette)
+{
+  setColorTable(palette.colorTable());
+}
+
+void ImageRemapper::setColorTable(const QVector<QRgb>& colors)
+{
+  p->colors = colors;
+  // Indices are stored in 16 bits
+  if (p->colors.size() > 0xffff)
+    p->colors.resize(0xffff);
+  for (QRgb& color : p->colors)
+    color |= 0xff000000;
+  p->build_lookup();
+}
+
+QVector<QRgb> ImageRemapper::colorTable() const
+{
+  return p->colors;
+}
+
+void ImageRemapper::setLookupBits(int bits)
+{
+  bits = qBound(5, bits, 6);
+  if (bits != p->bits)
+  {
+    p->bits = bits;
+    p->build_lookup();
+  }
+}
+
+int ImageRemapper::lookupBits() const
+{
+  return p->bits;
+}
+
+void ImageRemapper::setDithering(Dithering dithering)
+{
+  p->dithering = dithering;
+}
+
+ImageRemapper::Dithering ImageRemapper::dithering() const
+{
+  return p->dithering;
+}
+
+void ImageRemapper::setThreadCount(int threads)
+{
+  p->threads = qMax(0, threads);
+}
+
+int ImageRemapper::threadCount() const
+{
+  return p->threads;
+}
+
+int ImageRemapper::nearestIndex(QRgb rgb) const
+{
+  if (p->colors.empty())
+    return -1;
+  return p->nearest(qRed(rgb), qGreen(rgb), qBlue(rgb));
+}
+
+QImage ImageRemapper::remap(const QImage& image, OutputFormat format) const
+{
+  if (p->colors.empty() || image.isNull())
+    return QImage();
+
+  QImage source = image.convertToFormat(QImage::Format_RGB32);
+  bool indexed = format == IndexedOutput && p->colors.size() <= 256;
+  QImage out(source.size(), indexed ? QImage::Format_Indexed8 : QImage::Format_RGB32);
+  if (indexed)
+    out.setColorTable(p->colors);
+
+  // bits() detaches here, the threads then only write to their own lines
+  p->remap(
+      source,
+      {out.bits(),
+       out.bytesPerLine(),
+       indexed ? Output::Indexed8 : Output::Rgb32,
+       p->colors.constData()});
+
+  return out;
+}
+
+QVector<quint16> ImageRemapper::indices(const QImage& image) const
+{
+  if (p->colors.empty() || image.isNull())
+    return {};
+
+  QImage source = image.convertToFormat(QImage::Format_RGB32);
+  QVector<quint16> out(source.width() * source.height());
+  p->remap(
+      source,
+      {reinterpret_cast<uchar*>(out.data()),
+       int(source.width() * sizeof(quint16)),
+       Output::Index16,
+       p->colors.constData()});
+  return out;
+}
+
+} // namespace color_widgets
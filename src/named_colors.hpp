@@ -0,0 +1,459 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+#include <cstdint>
+
+namespace color_widgets
+{
+namespace detail
+{
+
+struct named_color
+{
+  const char* name;
+  std::uint32_t rgb; ///< 0xRRGGBB
+};
+
+/**
+ * \brief SVG color names, sorted by name
+ *
+ * When more names have the same color, the first one is used for reverse
+ * lookups.
+ */
+constexpr named_color named_colors[] = {
+    {"aliceblue", 0xf0f8ff},
+    {"antiquewhite", 0xfaebd7},
+    {"aqua", 0x00ffff},
+    {"aquamarine", 0x7fffd4},
+    {"azure", 0xf0ffff},
+    {"beige", 0xf5f5dc},
+    {"bisque", 0xffe4c4},
+    {"black", 0x000000},
+    {"blanchedalmond", 0xffebcd},
+    {"blue", 0x0000ff},
+    {"blueviolet", 0x8a2be2},
+    {"brown", 0xa52a2a},
+    {"burlywood", 0xdeb887},
+    {"cadetblue", 0x5f9ea0},
+    {"chartreuse", 0x7fff00},
+    {"chocolate", 0xd2691e},
+    {"coral", 0xff7f50},
+    {"cornflowerblue", 0x6495ed},
+    {"cornsilk", 0xfff8dc},
+    {"crimson", 0xdc143c},
+    {"cyan", 0x00ffff},
+    {"darkblue", 0x00008b},
+    {"darkcyan", 0x008b8b},
+    {"darkgoldenrod", 0xb8860b},
+    {"darkgray", 0xa9a9a9},
+    {"darkgreen", 0x006400},
+    {"darkgrey", 0xa9a9a9},
+    {"darkkhaki", 0xbdb76b},
+    {"darkmagenta", 0x8b008b},
+    {"darkolivegreen", 0x556b2f},
+    {"darkorange", 0xff8c00},
+    {"darkorchid", 0x9932cc},
+    {"darkred", 0x8b0000},
+    {"darksalmon", 0xe9967a},
+    {"darkseagreen", 0x8fbc8f},
+    {"darkslateblue", 0x483d8b},
+    {"darkslategray", 0x2f4f4f},
+    {"darkslategrey", 0x2f4f4f},
+    {"darkturquoise", 0x00ced1},
+    {"darkviolet", 0x9400d3},
+    {"deeppink", 0xff1493},
+    {"deepskyblue", 0x00bfff},
+    {"dimgray", 0x696969},
+    {"dimgrey", 0x696969},
+    {"dodgerblue", 0x1e90ff},
+    {"firebrick", 0xb22222},
+    {"floralwhite", 0xfffaf0},
+    {"forestgreen", 0x228b22},
+    {"fuchsia", 0xff00ff},
+    {"gainsboro", 0xdcdcdc},
+    {"ghostwhite", 0xf8f8ff},
+    {"gold", 0xffd700},
+    {"goldenrod", 0xdaa520},
+    {"gray", 0x808080},
+    {"green", 0x008000},
+    {"greenyellow", 0xadff2f},
+    {"grey", 0x808080},
+    {"honeydew", 0xf0fff0},
+    {"hotpink", 0xff69b4},
+    {"indianred", 0xcd5c5c},
+    {"indigo", 0x4b0082},
+    {"ivory", 0xfffff0},
+    {"khaki", 0xf0e68c},
+    {"lavender", 0xe6e6fa},
+    {"lavenderblush", 0xfff0f5},
+    {"lawngreen", 0x7cfc00},
+    {"lemonchiffon", 0xfffacd},
+    {"lightblue", 0xadd8e6},
+    {"lightcoral", 0xf08080},
+    {"lightcyan", 0xe0ffff},
+    {"lightgoldenrodyellow", 0xfafad2},
+    {"lightgray", 0xd3d3d3},
+    {"lightgreen", 0x90ee90},
+    {"lightgrey", 0xd3d3d3},
+    {"lightpink", 0xffb6c1},
+    {"lightsalmon", 0xffa07a},
+    {"lightseagreen", 0x20b2aa},
+    {"lightskyblue", 0x87cefa},
+    {"lightslategray", 0x778899},
+    {"lightslategrey", 0x778899},
+    {"lightsteelblue", 0xb0c4de},
+    {"lightyellow", 0xffffe0},
+    {"lime", 0x00ff00},
+    {"limegreen", 0x32cd32},
+    {"linen", 0xfaf0e6},
+    {"magenta", 0xff00ff},
+    {"maroon", 0x800000},
+    {"mediumaquamarine", 0x66cdaa},
+    {"mediumblue", 0x0000cd},
+    {"mediumorchid", 0xba55d3},
+    {"mediumpurple", 0x9370db},
+    {"mediumseagreen", 0x3cb371},
+    {"mediumslateblue", 0x7b68ee},
+    {"mediumspringgreen", 0x00fa9a},
+    {"mediumturquoise", 0x48d1cc},
+    {"mediumvioletred", 0xc71585},
+    {"midnightblue", 0x191970},
+    {"mintcream", 0xf5fffa},
+    {"mistyrose", 0xffe4e1},
+    {"moccasin", 0xffe4b5},
+    {"navajowhite", 0xffdead},
+    {"navy", 0x000080},
+    {"oldlace", 0xfdf5e6},
+    {"olive", 0x808000},
+    {"olivedrab", 0x6b8e23},
+    {"orange", 0xffa500},
+    {"orangered", 0xff4500},
+    {"orchid", 0xda70d6},
+    {"palegoldenrod", 0xeee8aa},
+    {"palegreen", 0x98fb98},
+    {"paleturquoise", 0xafeeee},
+    {"palevioletred", 0xdb7093},
+    {"papayawhip", 0xffefd5},
+    {"peachpuff", 0xffdab9},
+    {"peru", 0xcd853f},
+    {"pink", 0xffc0cb},
+    {"plum", 0xdda0dd},
+    {"powderblue", 0xb0e0e6},
+    {"purple", 0x800080},
+    {"red", 0xff0000},
+    {"rosybrown", 0xbc8f8f},
+    {"royalblue", 0x4169e1},
+    {"saddlebrown", 0x8b4513},
+    {"salmon", 0xfa8072},
+    {"sandybrown", 0xf4a460},
+    {"seagreen", 0x2e8b57},
+    {"seashell", 0xfff5ee},
+    {"sienna", 0xa0522d},
+    {"silver", 0xc0c0c0},
+    {"skyblue", 0x87ceeb},
+    {"slateblue", 0x6a5acd},
+    {"slategray", 0x708090},
+    {"slategrey", 0x708090},
+    {"snow", 0xfffafa},
+    {"springgreen", 0x00ff7f},
+    {"steelblue", 0x4682b4},
+    {"tan", 0xd2b48c},
+    {"teal", 0x008080},
+    {"thistle", 0xd8bfd8},
+    {"tomato", 0xff6347},
+    {"turquoise", 0x40e0d0},
+    {"violet", 0xee82ee},
+    {"wheat", 0xf5deb3},
+    {"white", 0xffffff},
+    {"whitesmoke", 0xf5f5f5},
+    {"yellow", 0xffff00},
+    {"yellowgreen", 0x9acd32},
+};
+
+constexpr int named_color_count = sizeof(named_colors) / sizeof(named_colors[0]);
+
+/// Length of the longest name
+constexpr int named_color_max_length = 20;
+
+constexpr int named_color_length(const char* name)
+{
+  int length = 0;
+  while (name[length])
+    length++;
+  return length;
+}
+
+/**
+ * \brief Seeded FNV-1a with a final avalanche step
+ */
+constexpr std::uint32_t named_color_hash(const char* name, int length, std::uint32_t seed)
+{
+  std::uint32_t hash = 2166136261u ^ (seed * 0x9e3779b9u);
+  for (int i = 0; i < length; i++)
+  {
+    hash ^= std::uint8_t(name[i]);
+    hash *= 16777619u;
+  }
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35u;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+/**
+ * \brief Perfect hash from names to indices in named_colors
+ *
+ * Names are first split in buckets, each bucket has a seed that places its
+ * names in free slots (hash and displace).
+ */
+struct named_color_hash_table
+{
+  static constexpr int buckets = 64;
+  static constexpr int slots = 256;
+
+  std::uint32_t seeds[buckets];
+  std::int16_t indices[slots]; ///< Index in named_colors or -1
+
+  static constexpr int bucket(const char* name, int length)
+  {
+    return named_color_hash(name, length, 0) % buckets;
+  }
+
+  constexpr int slot(const char* name, int length) const
+  {
+    return named_color_hash(name, length, seeds[bucket(name, length)]) % slots;
+  }
+};
+
+constexpr named_color_hash_table build_named_color_hash_table()
+{
+  named_color_hash_table table{};
+  for (int i = 0; i < named_color_hash_table::slots; i++)
+    table.indices[i] = -1;
+
+  int bucket_size[named_color_hash_table::buckets] = {};
+  int key_bucket[named_color_count] = {};
+  int key_length[named_color_count] = {};
+  for (int i = 0; i < named_color_count; i++)
+  {
+    key_length[i] = named_color_length(named_colors[i].name);
+    key_bucket[i] = named_color_hash_table::bucket(named_colors[i].name, key_length[i]);
+    bucket_size[key_bucket[i]]++;
+  }
+
+  // Place the largest buckets first, while there are many free slots
+  for (int size = named_color_count; size > 0; size--)
+  {
+    for (int bucket = 0; bucket < named_color_hash_table::buckets; bucket++)
+    {
+      if (bucket_size[bucket] != size)
+        continue;
+
+      for (std::uint32_t seed = 1;; seed++)
+      {
+        bool placed = true;
+        for (int i = 0; i < named_color_count && placed; i++)
+        {
+          if (key_bucket[i] != bucket)
+            continue;
+          int slot = named_color_hash(named_colors[i].name, key_length[i], seed)
+                     % named_color_hash_table::slots;
+          if (table.indices[slot] != -1)
+            placed = false;
+          else
+            table.indices[slot] = i;
+        }
+
+        if (placed)
+        {
+          table.seeds[bucket] = seed;
+          break;
+        }
+
+        // Roll back the names placed with this seed
+        for (int i = 0; i < named_color_count; i++)
+        {
+          if (key_bucket[i] != bucket)
+            continue;
+          int slot = named_color_hash(named_colors[i].name, key_length[i], seed)
+                     % named_color_hash_table::slots;
+          if (table.indices[slot] == i)
+            table.indices[slot] = -1;
+        }
+      }
+    }
+  }
+
+  return table;
+}
+
+constexpr named_color_hash_table named_color_table = build_named_color_hash_table();
+
+/**
+ * \brief Index in named_colors of the color with the given name
+ * \param name   Lower case name
+ * \param length Length of \p name
+ * \returns -1 if not found
+ */
+constexpr int find_named_color(const char* name, int length)
+{
+  if (length <= 0 || length > named_color_max_length)
+    return -1;
+
+  int index = named_color_table.indices[named_color_table.slot(name, length)];
+  if (index == -1)
+    return -1;
+
+  const char* candidate = named_colors[index].name;
+  for (int i = 0; i < length; i++)
+    if (candidate[i] != name[i])
+      return -1;
+  return candidate[length] == 0 ? index : -1;
+}
+
+/**
+ * \brief Coarse RGB grid used to find the nearest named color
+ *
+ * Entries are sorted by cell, cell \c i has the entries from \c start[i] to
+ * \c start[i+1].
+ */
+struct named_color_grid
+{
+  static constexpr int cell_bits = 6;
+  static constexpr int cells = 256 >> cell_bits;
+
+  std::uint8_t start[cells * cells * cells + 1];
+  std::uint8_t entries[named_color_count];
+
+  static constexpr int cell(int r, int g, int b) { return (r * cells + g) * cells + b; }
+
+  static constexpr int cell(std::uint32_t rgb)
+  {
+    return cell(
+        (rgb >> 16 & 0xff) >> cell_bits, (rgb >> 8 & 0xff) >> cell_bits, (rgb & 0xff) >> cell_bits);
+  }
+};
+
+constexpr named_color_grid build_named_color_grid()
+{
+  named_color_grid grid{};
+  const int cells = named_color_grid::cells * named_color_grid::cells * named_color_grid::cells;
+
+  int count[cells + 1] = {};
+  for (int i = 0; i < named_color_count; i++)
+    count[named_color_grid::cell(named_colors[i].rgb) + 1]++;
+  for (int i = 0; i < cells; i++)
+    count[i + 1] += count[i];
+  for (int i = 0; i <= cells; i++)
+    grid.start[i] = std::uint8_t(count[i]);
+  for (int i = 0; i < named_color_count; i++)
+    grid.entries[count[named_color_grid::cell(named_colors[i].rgb)]++] = std::uint8_t(i);
+
+  return grid;
+}
+
+constexpr named_color_grid named_color_cells = build_named_color_grid();
+
+/**
+ * \brief Index in named_colors of the color closest to \p rgb
+ * \param rgb      Color as 0xRRGGBB
+ * \param distance If not null, receives the squared euclidean RGB distance
+ *
+ * Ties go to the lowest index.
+ */
+constexpr int nearest_named_color(std::uint32_t rgb, int* distance = nullptr)
+{
+  const int bits = named_color_grid::cell_bits;
+  const int cells = named_color_grid::cells;
+  int r = rgb >> 16 & 0xff, g = rgb >> 8 & 0xff, b = rgb & 0xff;
+  int cr = r >> bits, cg = g >> bits, cb = b >> bits;
+  int best = -1;
+  int best_dist = 0;
+
+  for (int ring = 0; ring < cells; ring++)
+  {
+    // Colors in this ring are at least this far away
+    int reach = (ring > 0 ? ring - 1 : 0) << bits;
+    if (best != -1 && reach * reach > best_dist)
+      break;
+
+    for (int x = cr - ring; x <= cr + ring; x++)
+    {
+      for (int y = cg - ring; y <= cg + ring; y++)
+      {
+        for (int z = cb - ring; z <= cb + ring; z++)
+        {
+          if (x < 0 || y < 0 || z < 0 || x >= cells || y >= cells || z >= cells)
+            continue;
+          int dx = x > cr ? x - cr : cr - x;
+          int dy = y > cg ? y - cg : cg - y;
+          int dz = z > cb ? z - cb : cb - z;
+          if (dx != ring && dy != ring && dz != ring)
+            continue;
+
+          int cell = named_color_grid::cell(x, y, z);
+          for (int i = named_color_cells.start[cell]; i < named_color_cells.start[cell + 1]; i++)
+          {
+            int index = named_color_cells.entries[i];
+            std::uint32_t other = named_colors[index].rgb;
+            int dr = int(other >> 16 & 0xff) - r;
+            int dg = int(other >> 8 & 0xff) - g;
+            int db = int(other & 0xff) - b;
+            int dist = dr * dr + dg * dg + db * db;
+            if (best == -1 || dist < best_dist || (dist == best_dist && index < best))
+            {
+              best = index;
+              best_dist = dist;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  if (distance)
+    *distance = best_dist;
+  return best;
+}
+
+constexpr bool check_named_color_tables()
+{
+  for (int i = 0; i < named_color_count; i++)
+  {
+    const named_color& color = named_colors[i];
+    if (find_named_color(color.name, named_color_length(color.name)) != i)
+      return false;
+
+    int distance = -1;
+    int nearest = nearest_named_color(color.rgb, &distance);
+    if (distance != 0 || nearest > i || named_colors[nearest].rgb != color.rgb)
+      return false;
+  }
+  return true;
+}
+
+static_assert(check_named_color_tables(), "Named color lookup tables are inconsistent");
+
+} // namespace detail
+} // namespace color_widgets
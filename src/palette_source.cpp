@@ -0,0 +1,158 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "palette_source.hpp"
+
+#include "color_f.hpp"
+#include "gradient_sampler.hpp"
+
+#include <QMutex>
+
+#include <utility>
+
+namespace color_widgets
+{
+
+class PaletteSource::Private
+{
+public:
+  /// Number of colors generated at once
+  static const int block_size = 256;
+  /// Number of blocks kept in the cache
+  static const int cache_blocks = 4;
+
+  struct Block
+  {
+    int first = -1; ///< Index of the first color, -1 if unused
+    QRgb colors[block_size];
+  };
+
+  Generator generator;
+  int count;
+  Block cache[cache_blocks];
+  /// Block replaced on the next miss, blocks are replaced in turn
+  int next_block = 0;
+  QMutex mutex;
+
+  Private(const Generator& generator, int count) : generator(generator), count(qMax(0, count)) { }
+
+  /// Copies start with an empty cache
+  Private(const Private& other) : Private(other.generator, other.count) { }
+
+  QRgb rgb(int index)
+  {
+    QMutexLocker lock(&mutex);
+    int first = index - index % block_size;
+    for (const Block& block : cache)
+    {
+      if (block.first == first)
+        return block.colors[index - first];
+    }
+
+    Block& block = cache[next_block];
+    next_block = (next_block + 1) % cache_blocks;
+    block.first = first;
+    generator(first, qMin(block_size, count - first), block.colors);
+    return block.colors[index - first];
+  }
+};
+
+PaletteSource::PaletteSource(const Generator& generator, int count)
+    : p(new Private(generator, count))
+{
+}
+
+PaletteSource::PaletteSource(const PaletteSource& other) : p(new Private(*other.p)) { }
+
+PaletteSource& PaletteSource::operator=(const PaletteSource& other)
+{
+  if (this != &other)
+  {
+    delete p;
+    p = new Private(*other.p);
+  }
+  return *this;
+}
+
+PaletteSource::~PaletteSource()
+{
+  delete p;
+}
+
+PaletteSource::PaletteSource(PaletteSource&& other) : p(other.p)
+{
+  other.p = nullptr;
+}
+
+PaletteSource& PaletteSource::operator=(PaletteSource&& other)
+{
+  std::swap(p, other.p);
+  return *this;
+}
+
+int PaletteSource::count() const
+{
+  return p->count;
+}
+
+QRgb PaletteSource::rgbAt(int index) const
+{
+  return p->rgb(index);
+}
+
+PaletteSource PaletteSource::fromGradient(
+    const QGradientStops& stops, int count, GradientEditor::Interpolation interpolation)
+{
+  detail::gradient_sampler sampler(stops, interpolation);
+  float step = count > 1 ? 1.f / (count - 1) : 0;
+  return PaletteSource(
+      [sampler, step](int first, int count, QRgb* out) {
+        sampler.sample(first, step, count, out);
+      },
+      count);
+}
+
+PaletteSource PaletteSource::hueSweep(int count, qreal saturation, qreal value)
+{
+  float sat = float(saturation);
+  float val = float(value);
+  return PaletteSource(
+      [sat, val, total = count](int first, int count, QRgb* out) {
+        for (int i = 0; i < count; i++)
+        {
+          ColorF color = ColorF::fromHsvF(float(first + i) / total, sat, val);
+          out[i] = qRgb(
+              int(color.r * 255 + 0.5f), int(color.g * 255 + 0.5f), int(color.b * 255 + 0.5f));
+        }
+      },
+      count);
+}
+
+QVector<QRgb> PaletteSource::sampleGradient(
+    const QGradientStops& stops, int count, GradientEditor::Interpolation interpolation)
+{
+  QVector<QRgb> out(qMax(0, count));
+  float step = count > 1 ? 1.f / (count - 1) : 0;
+  detail::gradient_sampler(stops, interpolation).sample(0, step, out.size(), out.data());
+  return out;
+}
+
+} // namespace color_widgets
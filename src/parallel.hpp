@@ -0,0 +1,123 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace color_widgets
+{
+namespace detail
+{
+
+/**
+ * \brief Number of threads to use for \p jobs units of work
+ * \param requested Requested number of threads, 0 to use all the cores
+ */
+inline int thread_count(int requested, int jobs)
+{
+  int threads = requested > 0 ? requested : QThread::idealThreadCount();
+  return std::max(1, std::min(threads, jobs));
+}
+
+/**
+ * \brief Job of run_threads(), owned by the caller
+ */
+template<class Func>
+class thread_job : public QRunnable
+{
+public:
+  thread_job(const Func& func, int thread, QSemaphore& done)
+      : func(func), thread(thread), done(done)
+  {
+    setAutoDelete(false);
+  }
+
+  void run() override
+  {
+    func(thread);
+    done.release();
+  }
+
+private:
+  const Func& func;
+  int thread;
+  QSemaphore& done;
+};
+
+/**
+ * \brief Runs \p func(thread) for \p threads threads and waits for them
+ *
+ * The calling thread runs \p func(0), the others run on the global
+ * QThreadPool. Jobs the pool hasn't started by then are run by the calling
+ * thread, so they may not run concurrently and \p func must not wait for
+ * a higher thread index.
+ */
+template<class Func>
+void run_threads(int threads, const Func& func)
+{
+  QThreadPool* pool = QThreadPool::globalInstance();
+  QSemaphore done;
+  std::vector<std::unique_ptr<thread_job<Func>>> jobs;
+  jobs.reserve(std::max(0, threads - 1));
+  for (int i = 1; i < threads; i++)
+  {
+    jobs.emplace_back(new thread_job<Func>(func, i, done));
+    pool->start(jobs.back().get());
+  }
+
+  func(0);
+
+  for (auto& job : jobs)
+    if (pool->tryTake(job.get()))
+      job->run();
+  done.acquire(int(jobs.size()));
+}
+
+/**
+ * \brief Splits [begin, end) in contiguous ranges processed in parallel
+ *
+ * \p func(from, to) is called once per thread.
+ */
+template<class Func>
+void parallel_for(int begin, int end, int threads, const Func& func)
+{
+  int size = end - begin;
+  if (size <= 0)
+    return;
+
+  threads = std::max(1, std::min(threads, size));
+  run_threads(threads, [&](int thread) {
+    int from = begin + int(std::int64_t(size) * thread / threads);
+    int to = begin + int(std::int64_t(size) * (thread + 1) / threads);
+    func(from, to);
+  });
+}
+
+} // namespace detail
+} // namespace color_widgets
@@ -0,0 +1,218 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "recolor_preview.hpp"
+
+#include "parallel.hpp"
+
+#include <QPainter>
+#include <QPointer>
+
+#include <wobjectimpl.h>
+
+W_OBJECT_IMPL(color_widgets::RecolorPreview)
+namespace color_widgets
+{
+
+class RecolorPreview::Private
+{
+public:
+  QImage image;
+  QPointer<ColorPalette> palette;
+  QList<QMetaObject::Connection> connections;
+  ImageRemapper remapper;
+
+  /// Palette index of each pixel, row by row
+  QVector<quint16> indices;
+  /// Pixels using index i are pixels[offsets[i]] to pixels[offsets[i+1]]
+  QVector<int> offsets;
+  QVector<quint32> pixels;
+  /// Color currently drawn for each palette index
+  QVector<QRgb> colors;
+  /// Image with colors applied, RGB32 lines are packed so pixels are
+  /// addressed as y * width + x
+  QImage recolored;
+  /// Whether the image needs to be mapped to the palette again
+  bool mapping_dirty = false;
+
+  /**
+   * \brief Maps the image to palette indices and builds the pixel lists
+   */
+  void map()
+  {
+    mapping_dirty = false;
+    indices.clear();
+    offsets.clear();
+    pixels.clear();
+    colors.clear();
+    recolored = QImage();
+
+    if (image.isNull() || !palette || palette->count() == 0)
+      return;
+
+    remapper.setPalette(*palette);
+    colors = remapper.colorTable();
+    indices = remapper.indices(image);
+
+    // Counting sort of the pixels by index
+    offsets.fill(0, colors.size() + 1);
+    for (quint16 index : indices)
+      offsets[index + 1]++;
+    for (int i = 0; i < colors.size(); i++)
+      offsets[i + 1] += offsets[i];
+    QVector<int> next = offsets;
+    pixels.resize(indices.size());
+    for (int i = 0; i < indices.size(); i++)
+      pixels[next[indices[i]]++] = quint32(i);
+
+    recolored = QImage(image.size(), QImage::Format_RGB32);
+    QRgb* out = reinterpret_cast<QRgb*>(recolored.bits());
+    const quint16* in = indices.constData();
+    const QRgb* lut = colors.constData();
+    int size = indices.size();
+    detail::parallel_for(0, size, detail::thread_count(0, size / 65536), [=](int from, int to) {
+      for (int i = from; i < to; i++)
+        out[i] = lut[in[i]];
+    });
+  }
+
+  /**
+   * \brief Redraws the pixels mapped to \p index
+   * \returns \b true if the image has changed
+   */
+  bool recolor(int index)
+  {
+    if (mapping_dirty || !palette || index < 0 || index >= colors.size())
+      return false;
+
+    QRgb color = palette->colorAt(index).rgb();
+    if (color == colors[index])
+      return false;
+    colors[index] = color;
+
+    QRgb* out = reinterpret_cast<QRgb*>(recolored.bits());
+    const quint32* list = pixels.constData() + offsets[index];
+    int size = offsets[index + 1] - offsets[index];
+    detail::parallel_for(0, size, detail::thread_count(0, size / 65536), [=](int from, int to) {
+      for (int i = from; i < to; i++)
+        out[list[i]] = color;
+    });
+    return true;
+  }
+};
+
+RecolorPreview::RecolorPreview(QWidget* parent) : QWidget(parent), p(new Private) { }
+
+RecolorPreview::~RecolorPreview()
+{
+  delete p;
+}
+
+QSize RecolorPreview::sizeHint() const
+{
+  if (p->image.isNull())
+    return QSize(128, 128);
+  return p->image.size().scaled(256, 256, Qt::KeepAspectRatio);
+}
+
+QImage RecolorPreview::image() const
+{
+  return p->image;
+}
+
+QImage RecolorPreview::recoloredImage() const
+{
+  if (p->mapping_dirty)
+    p->map();
+  return p->recolored;
+}
+
+ColorPalette* RecolorPreview::colorPalette() const
+{
+  return p->palette;
+}
+
+void RecolorPreview::setColorPalette(ColorPalette* palette)
+{
+  if (palette == p->palette)
+    return;
+
+  for (const auto& connection : p->connections)
+    disconnect(connection);
+  p->connections.clear();
+
+  p->palette = palette;
+  if (palette)
+  {
+    auto remap = [this] {
+      p->mapping_dirty = true;
+      update();
+    };
+    p->connections << connect(palette, &ColorPalette::colorChanged, this, [this](int index) {
+      if (p->recolor(index))
+        update();
+    });
+    p->connections << connect(palette, &ColorPalette::colorAdded, this, remap);
+    p->connections << connect(palette, &ColorPalette::colorRemoved, this, remap);
+    p->connections << connect(palette, &ColorPalette::colorsChanged, this, remap);
+  }
+
+  p->mapping_dirty = true;
+  update();
+}
+
+ImageRemapper::Dithering RecolorPreview::dithering() const
+{
+  return p->remapper.dithering();
+}
+
+void RecolorPreview::setDithering(ImageRemapper::Dithering dithering)
+{
+  if (dithering == p->remapper.dithering())
+    return;
+  p->remapper.setDithering(dithering);
+  p->mapping_dirty = true;
+  update();
+}
+
+void RecolorPreview::setImage(const QImage& image)
+{
+  p->image = image;
+  p->mapping_dirty = true;
+  update();
+  imageChanged(image);
+}
+
+void RecolorPreview::paintEvent(QPaintEvent*)
+{
+  if (p->mapping_dirty)
+    p->map();
+  if (p->recolored.isNull())
+    return;
+
+  // Without smooth scaling only the pixels being shown are read
+  QSize size = p->recolored.size().scaled(this->size(), Qt::KeepAspectRatio);
+  QRect target(QPoint((width() - size.width()) / 2, (height() - size.height()) / 2), size);
+  QPainter painter(this);
+  painter.drawImage(target, p->recolored);
+}
+
+} // namespace color_widgets
@@ -22,6 +22,7 @@
 #include "swatch.hpp"
 
 #include "color_utils.hpp"
+#include "contrast_audit.hpp"
 
 #include <QApplication>
 #include <QDrag>
@@ -56,6 +57,8 @@ public:
   int forced_rows;
   int forced_columns;
   bool readonly; ///< Whether the palette can be modified via user interaction
+  QColor contrast_background; ///< Background for the contrast check (invalid to disable)
+  qreal minimum_contrast;
 
   QPoint drag_pos;     ///< Point used to keep track of dragging
   int drag_index;      ///< Index used by drags
@@ -76,6 +79,7 @@ public:
       , forced_rows(0)
       , forced_columns(0)
       , readonly(false)
+      , minimum_contrast(4.5)
       , drag_index(-1)
       , drop_index(-1)
       , drop_overwrite(false)
@@ -349,7 +353,7 @@ void Swatch::paintEvent(QPaintEvent* event)
   QColor colorEmptyBorder = p->border.color();
   colorEmptyBorder.setAlpha(56);
   penEmptyBorder.setColor(colorEmptyBorder);
-  QPainter painter(this);
+  detail::simulated_painter painter(this);
 
   QStyleOptionFrame panel;
   panel.initFrom(this);
@@ -360,23 +364,46 @@ void Swatch::paintEvent(QPaintEvent* event)
   QRect r = style()->subElementRect(QStyle::SE_FrameContents, &panel, this);
   painter.setClipRect(r);
 
+  bool check_contrast = p->contrast_background.isValid();
+  QRgb contrast_background = check_contrast ? p->contrast_background.rgb() : 0;
+
   int count = p->palette.count();
   painter.setPen(p->border);
   for (int y = 0, i = 0; i < count; y++)
   {
     for (int x = 0; x < rowcols.width() && i < count; x++, i++)
     {
-      if (p->palette.colorAt(i) == p->emptyColor)
+      // Palettes may compute their colors, only the visible ones are read
+      QRectF rect = p->indexRect(i, rowcols, color_size);
+      if (!event->rect().intersects(rect.toAlignedRect()))
+        continue;
+      QColor color = p->palette.colorAt(i);
+      if (color == p->emptyColor)
       {
         painter.setBrush(Qt::NoBrush);
         painter.setPen(penEmptyBorder);
-        painter.drawRect(p->indexRect(i, rowcols, color_size));
+        painter.drawRect(rect);
         continue;
       }
       painter.setBrush(alpha_pattern);
-      painter.drawRect(p->indexRect(i, rowcols, color_size));
-      painter.setBrush(p->palette.colorAt(i));
-      painter.drawRect(p->indexRect(i, rowcols, color_size));
+      painter.drawRect(rect);
+      painter.setBrush(color);
+      painter.drawRect(rect);
+
+      if (check_contrast)
+      {
+        float ratio = ContrastAudit::contrastRatio(color.rgb(), contrast_background);
+        if (ratio < p->minimum_contrast)
+        {
+          // Black or white, whichever stands out more on the swatch
+          // (they tie at a relative luminance of about 0.18)
+          bool dark = ContrastAudit::luminance(color.rgb()) > 0.179f;
+          QPen pen = painter.pen();
+          painter.setPen(QPen(dark ? Qt::black : Qt::white, 2));
+          painter.drawLine(rect.topRight(), rect.bottomLeft());
+          painter.setPen(pen);
+        }
+      }
     }
   }
 
@@ -729,4 +756,35 @@ void Swatch::setEmptyColor(const QColor& emptyColor)
   }
 }
 
+QColor Swatch::contrastBackground() const
+{
+  return p->contrast_background;
+}
+
+void Swatch::setContrastBackground(const QColor& contrastBackground)
+{
+  if (contrastBackground != p->contrast_background)
+  {
+    p->contrast_background = contrastBackground;
+    contrastBackgroundChanged(contrastBackground);
+    update();
+  }
+}
+
+qreal Swatch::minimumContrast() const
+{
+  return p->minimum_contrast;
+}
+
+void Swatch::setMinimumContrast(qreal minimumContrast)
+{
+  minimumContrast = qMax(qreal(1), minimumContrast);
+  if (minimumContrast != p->minimum_contrast)
+  {
+    p->minimum_contrast = minimumContrast;
+    minimumContrastChanged(minimumContrast);
+    update();
+  }
+}
+
 } // namespace color_widgets
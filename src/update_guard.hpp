@@ -0,0 +1,76 @@
+/**
+ * \file
+ *
+ * \author Mattia Basaglia
+ *
+ * \copyright Copyright (C) 2015 Mattia Basaglia
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+#include "color_updates.hpp"
+
+#include <QColor>
+
+namespace color_widgets
+{
+namespace detail
+{
+
+/**
+ * \brief Whether two components in [0-1] differ by at most colorTolerance()
+ */
+bool fuzzy_same(qreal a, qreal b);
+
+/**
+ * \brief Whether two colors have the same RGBA components within colorTolerance()
+ */
+bool fuzzy_same(const QColor& a, const QColor& b);
+
+/**
+ * \brief Guards a setter from re-entrant calls and counts it in colorUpdateStats()
+ *
+ * \code
+ * detail::update_guard guard(p->updating);
+ * if (!guard.enter(!detail::fuzzy_same(color, p->color)))
+ *   return;
+ * \endcode
+ */
+class update_guard
+{
+public:
+  explicit update_guard(bool& updating) : updating(updating) { }
+  update_guard(const update_guard&) = delete;
+  update_guard& operator=(const update_guard&) = delete;
+
+  ~update_guard()
+  {
+    if (entered)
+      updating = false;
+  }
+
+  /**
+   * \brief Whether the setter should go on
+   * \param changed Whether the new value differs from the current one
+   */
+  bool enter(bool changed);
+
+private:
+  bool& updating;
+  bool entered = false;
+};
+
+} // namespace detail
+} // namespace color_widgets